@@ -3,7 +3,6 @@
 #include "byte_stream.hh"
 #include "eventloop.hh"
 
-#include <algorithm>
 #include <iostream>
 #include <unistd.h>
 
@@ -30,7 +29,7 @@ void bidirectional_stream_copy(Socket &socket) {
         _input,
         Direction::In,
         [&] {
-            _outbound.write(_input.read(_outbound.remaining_capacity()));
+            _outbound.write_from_fd(_input);
             if (_input.eof()) {
                 _outbound.end_input();
             }
@@ -42,9 +41,7 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(socket,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-                            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
-                            _outbound.pop_output(bytes_written);
+                            _outbound.read_into_fd(socket, max_copy_length);
                             if (_outbound.eof()) {
                                 socket.shutdown(SHUT_WR);
                                 _outbound_shutdown = true;
@@ -58,7 +55,7 @@ void bidirectional_stream_copy(Socket &socket) {
         socket,
         Direction::In,
         [&] {
-            _inbound.write(socket.read(_inbound.remaining_capacity()));
+            _inbound.write_from_fd(socket);
             if (socket.eof()) {
                 _inbound.end_input();
             }
@@ -70,9 +67,7 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(_output,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-                            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
-                            _inbound.pop_output(bytes_written);
+                            _inbound.read_into_fd(_output, max_copy_length);
 
                             if (_inbound.eof()) {
                                 _output.close();
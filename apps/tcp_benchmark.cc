@@ -1,17 +1,28 @@
+#include "byte_stream.hh"
+#include "fd_adapter.hh"
+#include "ipv4_datagram.hh"
+#include "lossy_fd_adapter.hh"
+#include "segment_coalescer.hh"
 #include "tcp_connection.hh"
+#include "tcp_over_ip.hh"
 
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <queue>
 #include <string>
+#include <utility>
 
 using namespace std;
 using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+//! \returns the number of segments moved
+size_t move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+    const size_t count = x.segments_out().size();
     while (not x.segments_out().empty()) {
         segments.emplace_back(move(x.segments_out().front()));
         x.segments_out().pop();
@@ -26,10 +37,13 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
         }
     }
     segments.clear();
+    return count;
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const bool zero_copy = false, const bool delayed_ack = false) {
     TCPConfig config;
+    config.zero_copy_send = zero_copy;
+    config.delayed_ack = delayed_ack;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -42,6 +56,7 @@ void main_loop(const bool reorder) {
     y.end_input_stream();
 
     bool x_closed = false;
+    size_t data_segments = 0, ack_segments = 0;
 
     string string_received;
     string_received.reserve(len);
@@ -52,7 +67,14 @@ void main_loop(const bool reorder) {
         // write input into x
         while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
             const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
-            const auto written = x.write(string(bytes_to_send.str().substr(0, want)));
+            size_t written;
+            if (zero_copy) {
+                Buffer slice = bytes_to_send;
+                slice.remove_suffix(slice.size() - want);
+                written = x.write(slice);
+            } else {
+                written = x.write(string(bytes_to_send.str().substr(0, want)));
+            }
             if (want != written) {
                 throw runtime_error("want = " + to_string(want) + ", written = " + to_string(written));
             }
@@ -66,8 +88,8 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        data_segments += move_segments(x, y, segments, reorder);
+        ack_segments += move_segments(y, x, segments, false);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
@@ -94,19 +116,327 @@ void main_loop(const bool reorder) {
 
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
+    const string variant = reorder       ? " with reordering"
+                           : zero_copy   ? " with zero-copy"
+                           : delayed_ack ? " with delayed ACKs"
+                                         : "";
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput" << variant << string(18 - variant.size(), ' ') << ": " << gigabits_per_second
+         << " Gbit/s, " << data_segments << " segments sent, " << ack_segments << " returned\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+void byte_stream_loop() {
+    constexpr size_t chunk = TCPConfig::MAX_PAYLOAD_SIZE;
+    ByteStream stream{TCPConfig::DEFAULT_CAPACITY};
+    const string string_to_send(chunk, 'x');
+
+    size_t bytes_received = 0;
+
+    const auto first_time = high_resolution_clock::now();
+
+    // keep the stream about half full, the way a sender's outbound stream usually is
+    while (bytes_received < len) {
+        while (stream.remaining_capacity() >= chunk) {
+            stream.write(string_to_send);
+        }
+        while (stream.buffer_size() > TCPConfig::DEFAULT_CAPACITY / 2) {
+            bytes_received += stream.read(chunk).size();
+        }
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto gigabits_per_second = bytes_received * 8.0 / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << "ByteStream throughput                   : " << gigabits_per_second << " Gbit/s\n";
+}
+
+//! \returns the number of datagrams that carried the segments from `x` to `y`, each serialized and parsed again
+//! (and, with a `coalescer`, merged again before `y` sees them)
+size_t carry_over_ip(TCPConnection &x,
+                     TCPOverIPv4Adapter &from,
+                     TCPOverIPv4Adapter &to,
+                     TCPConnection &y,
+                     optional<SegmentCoalescer> &coalescer) {
+    size_t count = 0;
+    while (not x.segments_out().empty()) {
+        for (const auto &dgram : from.wrap_tcp_in_ip(x.segments_out().front())) {
+            InternetDatagram received;
+            if (received.parse(dgram.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("datagram unparseable");
+            }
+            auto seg = to.unwrap_tcp_in_ip(received);
+            if (not seg.has_value()) {
+                throw runtime_error("segment lost in unwrapping");
+            }
+            if (coalescer.has_value()) {
+                coalescer->segment_received(move(seg.value()));
+            } else {
+                y.segment_received(seg.value());
+            }
+            count++;
+        }
+        x.segments_out().pop();
+    }
+    if (coalescer.has_value()) {
+        coalescer->flush();
+        while (not coalescer->segments_out().empty()) {
+            y.segment_received(coalescer->segments_out().front());
+            coalescer->segments_out().pop();
+        }
+    }
+    return count;
+}
+
+void offload_loop(const bool offload, const bool receive_offload = false) {
+    TCPConfig config;
+    config.mss = TCPOverIPv4Adapter::mss();
+    config.segmentation_offload = offload;
+    TCPConnection x{config}, y{config};
+    optional<SegmentCoalescer> x_coalescer{}, y_coalescer{};
+    if (receive_offload) {
+        y_coalescer.emplace();
+    }
+
+    TCPOverIPv4Adapter x_adapter, y_adapter;
+    x_adapter.config_mut().source = y_adapter.config_mut().destination = {"10.0.0.1", 1234};
+    x_adapter.config_mut().destination = y_adapter.config_mut().source = {"10.0.0.2", 5678};
+
+    const string string_to_send(len, 'x');
+    Buffer bytes_to_send{string(string_to_send)};
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+    size_t data_segments = 0, data_datagrams = 0;
+
+    string string_received;
+    string_received.reserve(len);
+
+    const auto first_time = high_resolution_clock::now();
+
+    auto loop = [&] {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
+            bytes_to_send.remove_prefix(x.write(string(bytes_to_send.str().substr(0, want))));
+        }
+
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        data_segments += x.segments_out().size();
+        data_datagrams += carry_over_ip(x, x_adapter, y_adapter, y, y_coalescer);
+        carry_over_ip(y, y_adapter, x_adapter, x, x_coalescer);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            string_received.append(y.inbound_stream().read(available_output));
+        }
+
+        x.tick(1000);
+        y.tick(1000);
+    };
+
+    while (not y.inbound_stream().eof()) {
+        loop();
+    }
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto gigabits_per_second = len * 8.0 / double(duration);
+
+    const string variant = receive_offload ? " with GSO+GRO" : offload ? " with offload" : "";
+    cout << fixed << setprecision(2);
+    cout << "CPU-limited IPv4 throughput" << variant << string(13 - variant.size(), ' ') << ": " << gigabits_per_second
+         << " Gbit/s, " << data_segments << " segments sent in " << data_datagrams << " datagrams\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+//! A one-way bottleneck link, in simulated time: segments are serialized at a fixed rate,
+//! wait in a drop-tail queue, then take a fixed propagation delay
+class SimulatedLink : public FdAdapterBase {
+  private:
+    double _bytes_per_ms;
+    size_t _delay_ms;
+    double _queue_ms;
+    size_t _now{0};
+    double _busy_until{0};
+    std::queue<std::pair<double, TCPSegment>> _in_transit{};
+
+  public:
+    SimulatedLink(const double bytes_per_ms = 1250, const size_t delay_ms = 10, const double queue_ms = 50)
+        : _bytes_per_ms(bytes_per_ms), _delay_ms(delay_ms), _queue_ms(queue_ms) {}
+
+    optional<TCPSegment> read() {
+        if (_in_transit.empty() or _in_transit.front().first > _now) {
+            return {};
+        }
+        auto seg = move(_in_transit.front().second);
+        _in_transit.pop();
+        return seg;
+    }
+
+    void write(TCPSegment &seg) {
+        if (_busy_until > _now + _queue_ms) {  // queue full
+            return;
+        }
+        const size_t wire_size = seg.header().serialize().size() + seg.payload().size();
+        _busy_until = max(_busy_until, static_cast<double>(_now)) + wire_size / _bytes_per_ms;
+        _in_transit.emplace(_busy_until + _delay_ms, seg);
+    }
+
+    void tick(const size_t ms_since_last_tick) { _now += ms_since_last_tick; }
+};
+
+//! \returns the throughput, in Mbit/s, of a transfer over `path` that loses `loss_rate_up` of data segments
+double simulated_transfer(const TCPConfig &config,
+                          const SimulatedLink &path,
+                          const uint16_t loss_rate_up,
+                          const size_t lossy_len) {
+    constexpr size_t max_ms = 600 * 1000;
+
+    TCPConnection x{config}, y{config};
+
+    // data segments (but no ACKs) are lost on the way
+    LossyFdAdapter<SimulatedLink> uplink{SimulatedLink{path}}, downlink{SimulatedLink{path}};
+    uplink.config_mut().loss_rate_up = loss_rate_up;
+
+    x.connect();
+    y.end_input_stream();
+
+    size_t bytes_written = 0, bytes_received = 0, ms = 0, finish_ms = 0;
+
+    auto carry = [](TCPConnection &from, LossyFdAdapter<SimulatedLink> &link, TCPConnection &to) {
+        while (not from.segments_out().empty()) {
+            link.write(from.segments_out().front());
+            from.segments_out().pop();
+        }
+        for (auto seg = link.read(); seg.has_value(); seg = link.read()) {
+            to.segment_received(seg.value());
+        }
+    };
+
+    while ((x.active() or y.active()) and ms < max_ms) {
+        while (bytes_written < lossy_len and x.remaining_outbound_capacity()) {
+            bytes_written += x.write(string(min(x.remaining_outbound_capacity(), lossy_len - bytes_written), 'x'));
+            if (bytes_written == lossy_len) {
+                x.end_input_stream();
+            }
+        }
+
+        carry(x, uplink, y);
+        carry(y, downlink, x);
+
+        bytes_received += y.inbound_stream().read(y.inbound_stream().buffer_size()).size();
+        if (y.inbound_stream().eof() and finish_ms == 0) {
+            finish_ms = ms;
+        }
+
+        x.tick(1);
+        y.tick(1);
+        uplink.tick(1);
+        downlink.tick(1);
+        ms++;
+    }
+
+    if (bytes_received != lossy_len) {
+        throw runtime_error("lossy transfer incomplete: received " + to_string(bytes_received) + " bytes");
+    }
+
+    return lossy_len * 8.0 / 1000.0 / double(finish_ms);
+}
+
+void lossy_loop(const TCPConfig::CongestionControl congestion_control) {
+    TCPConfig config;
+    config.rt_timeout = 100;
+    config.adaptive_rto = true;
+    config.sack = true;
+    config.congestion_control = congestion_control;
+
+    const auto megabits_per_second = simulated_transfer(config, SimulatedLink{}, UINT16_MAX / 100, 4 * 1024 * 1024);
+
+    const string name = CongestionController::create(congestion_control, TCPConfig::MAX_PAYLOAD_SIZE)->name();
+    cout << fixed << setprecision(2);
+    cout << "10 Mbit/s, 20 ms RTT, 1% loss (" << name << ")" << string(8 - name.size(), ' ')
+         << ": " << megabits_per_second << " Mbit/s\n";
+}
+
+void window_scaling_loop(const bool window_scaling) {
+    TCPConfig config;
+    config.rt_timeout = 200;
+    config.adaptive_rto = true;
+    config.sack = true;
+    config.congestion_control = TCPConfig::CongestionControl::Cubic;
+    config.window_scaling = window_scaling;
+    config.recv_capacity = 1024 * 1024;
+    config.send_capacity = 1024 * 1024;
+
+    // 100 Mbit/s with a 50 ms RTT: a bandwidth-delay product of 625 kB
+    const auto megabits_per_second = simulated_transfer(config, SimulatedLink{12500, 25}, 0, 16 * 1024 * 1024);
+
+    cout << fixed << setprecision(2);
+    cout << "100 Mbit/s, 50 ms RTT, 1 MB window, " << (window_scaling ? "scaled  " : "unscaled")
+         << ": " << megabits_per_second << " Mbit/s\n";
+}
+
+void pacing_loop(const bool pacing) {
+    TCPConfig config;
+    config.rt_timeout = 200;
+    config.adaptive_rto = true;
+    config.sack = true;
+    config.congestion_control = TCPConfig::CongestionControl::Cubic;
+    config.window_scaling = true;
+    config.recv_capacity = 1024 * 1024;
+    config.send_capacity = 1024 * 1024;
+    config.pacing = pacing;
+
+    // 100 Mbit/s with a 20 ms RTT, behind a queue that drains in 1 ms (about a dozen segments)
+    const auto megabits_per_second = simulated_transfer(config, SimulatedLink{12500, 10, 1}, 0, 16 * 1024 * 1024);
+
+    cout << fixed << setprecision(2);
+    cout << "100 Mbit/s, 20 ms RTT, 1 ms queue, " << (pacing ? "paced   " : "unpaced ") << " : " << megabits_per_second
+         << " Mbit/s\n";
+}
+
 int main() {
     try {
+        byte_stream_loop();
         main_loop(false);
         main_loop(true);
+        main_loop(false, true);
+        main_loop(false, false, true);
+        offload_loop(false);
+        offload_loop(true);
+        offload_loop(true, true);
+        for (const auto cc : {TCPConfig::CongestionControl::None,
+                              TCPConfig::CongestionControl::Reno,
+                              TCPConfig::CongestionControl::NewReno,
+                              TCPConfig::CongestionControl::Cubic,
+                              TCPConfig::CongestionControl::Bbr}) {
+            lossy_loop(cc);
+        }
+        window_scaling_loop(false);
+        window_scaling_loop(true);
+        pacing_loop(false);
+        pacing_loop(true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,31 +15,155 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity)
-    : pipe(), _capacity(capacity), _nbytes_read(0), _nbytes_written(0), _end(false), _eof(false) {}
+//! \returns the smallest power of two that is at least `n` (and at least 1)
+static size_t ring_size_for(const size_t n) {
+    size_t size = 1;
+    while (size < n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+ByteStream::ByteStream(const size_t capacity, const bool chunked)
+    : _ring(chunked ? 1 : ring_size_for(capacity), 0)
+    , _mask(_ring.size() - 1)
+    , _chunked(chunked)
+    , _capacity(capacity)
+    , _nbytes_read(0)
+    , _nbytes_written(0)
+    , _end(false)
+    , _eof(false) {}
+
+void ByteStream::copy_out(char *dst, const size_t pos, const size_t len) const {
+    const size_t first = min(len, _ring.size() - pos);
+    memcpy(dst, _ring.data() + pos, first);
+    memcpy(dst + first, _ring.data(), len - first);
+}
+
+size_t ByteStream::copy_in(const string_view data) {
+    const size_t len = min(data.size(), remaining_capacity());
+    const size_t pos = _nbytes_written & _mask;
+    const size_t first = min(len, _ring.size() - pos);
+    memcpy(_ring.data() + pos, data.data(), first);
+    memcpy(_ring.data(), data.data() + first, len - first);
+    _nbytes_written += len;
+    return len;
+}
 
 size_t ByteStream::write(const string &data) {
-    size_t i = 0;
-    for (; i < data.size() && remaining_capacity() > 0; i++, _nbytes_written++) {
-        pipe.push_back(data[i]);
+    if (not _chunked) {
+        return copy_in(data);
+    }
+
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len > 0) {
+        _chunks.emplace_back(data.substr(0, len));
+        _nbytes_written += len;
+    }
+    return len;
+}
+
+size_t ByteStream::write(Buffer data) {
+    if (not _chunked) {
+        return copy_in(data);
+    }
+
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len > 0) {
+        data.remove_suffix(data.size() - len);
+        _nbytes_written += len;
+        _chunks.push_back(move(data));
+    }
+    return len;
+}
+
+//! \param[in] fd the file descriptor to read from; it is read at most once
+size_t ByteStream::write_from_fd(FileDescriptor &fd) {
+    if (_chunked) {
+        string data;
+        fd.read(data, remaining_capacity());
+        return write(Buffer{move(data)});
+    }
+
+    const size_t len = remaining_capacity();
+    const size_t pos = _nbytes_written & _mask;
+    const size_t first = min(len, _ring.size() - pos);
+    vector<iovec> free_space{{_ring.data() + pos, first}};
+    if (len > first) {
+        free_space.push_back({_ring.data(), len - first});
+    }
+
+    const size_t bytes_read = fd.read(free_space);
+    _nbytes_written += bytes_read;
+    return bytes_read;
+}
+
+deque<string_view> ByteStream::peek_views(const size_t len) const {
+    deque<string_view> views;
+    size_t remaining = min(len, buffer_size());
+    if (not _chunked) {
+        const size_t pos = _nbytes_read & _mask;
+        const size_t first = min(remaining, _ring.size() - pos);
+        views.emplace_back(_ring.data() + pos, first);
+        if (remaining > first) {
+            views.emplace_back(_ring.data(), remaining - first);
+        }
+        return views;
+    }
+
+    for (auto it = _chunks.begin(); remaining > 0; ++it) {
+        const string_view view = it->str().substr(0, remaining);
+        views.push_back(view);
+        remaining -= view.size();
     }
-    return i;
+    return views;
+}
+
+//! \param[in] len bytes will be referenced from the output side of the buffer
+vector<iovec> ByteStream::peek_iovecs(const size_t len) const {
+    return BufferViewList{peek_views(len)}.as_iovecs();
+}
+
+//! \param[in] fd the file descriptor to write to; it is written at most once
+//! \param[in] len the most bytes to write
+size_t ByteStream::read_into_fd(FileDescriptor &fd, const size_t len) {
+    if (buffer_empty()) {
+        return 0;
+    }
+    const size_t bytes_written = fd.write(BufferViewList{peek_views(len)}, false);
+    pop_output(bytes_written);
+    return bytes_written;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    string out;
-    for (size_t i = 0; i < len && i < pipe.size(); i++) {
-        out += pipe[i];
+    string out(min(len, buffer_size()), 0);
+    if (not _chunked) {
+        copy_out(out.data(), _nbytes_read & _mask, out.size());
+        return out;
+    }
+
+    size_t copied = 0;
+    for (auto it = _chunks.begin(); copied < out.size(); ++it) {
+        const size_t n = min(it->size(), out.size() - copied);
+        memcpy(out.data() + copied, it->str().data(), n);
+        copied += n;
     }
     return out;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    size_t i = 0;
-    for (; i < len && !buffer_empty(); i++, _nbytes_read++) {
-        pipe.pop_front();
+    size_t n = min(len, buffer_size());
+    _nbytes_read += n;
+    while (_chunked and n > 0) {
+        if (n < _chunks.front().size()) {
+            _chunks.front().remove_prefix(n);
+            n = 0;
+        } else {
+            n -= _chunks.front().size();
+            _chunks.pop_front();
+        }
     }
     if (input_ended() && buffer_empty())
         _eof = true;
@@ -51,6 +178,37 @@ std::string ByteStream::read(const size_t len) {
     return out;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \returns the bytes, as one Buffer per written chunk in chunked mode
+BufferList ByteStream::read_buffers(const size_t len) {
+    if (not _chunked) {
+        return read(len);
+    }
+
+    BufferList out;
+    size_t remaining = min(len, buffer_size());
+    for (auto it = _chunks.begin(); remaining > 0; ++it) {
+        Buffer slice = *it;
+        if (slice.size() > remaining) {
+            slice.remove_suffix(slice.size() - remaining);
+        }
+        remaining -= slice.size();
+        out.append(slice);
+    }
+    pop_output(len);
+    return out;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \returns a Buffer
+Buffer ByteStream::read_buffer(const size_t len) {
+    const BufferList out = read_buffers(len);
+    if (out.buffers().size() <= 1) {
+        return out;
+    }
+    return out.concatenate();
+}
+
 void ByteStream::end_input() {
     _end = true;
     if (buffer_empty())
@@ -59,9 +217,9 @@ void ByteStream::end_input() {
 
 bool ByteStream::input_ended() const { return _end; }
 
-size_t ByteStream::buffer_size() const { return pipe.size(); }
+size_t ByteStream::buffer_size() const { return _nbytes_written - _nbytes_read; }
 
-bool ByteStream::buffer_empty() const { return pipe.empty(); }
+bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
 
 bool ByteStream::eof() const { return _eof; }
 
@@ -69,4 +227,4 @@ size_t ByteStream::bytes_written() const { return _nbytes_written; }
 
 size_t ByteStream::bytes_read() const { return _nbytes_read; }
 
-size_t ByteStream::remaining_capacity() const { return _capacity - pipe.size(); }
+size_t ByteStream::remaining_capacity() const { return _capacity - buffer_size(); }
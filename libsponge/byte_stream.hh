@@ -1,19 +1,40 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "file_descriptor.hh"
+
 #include <deque>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
 
 //! \brief An in-order byte stream.
 
 //! Bytes are written on the "input" side and read from the "output"
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
+//!
+//! The bytes live in a power-of-two ring, so writes, peeks and pops
+//! are at most two memcpy()s each. A stream constructed in "chunked"
+//! mode instead keeps the written Buffers themselves, so that a Buffer
+//! written in can be read back out (via read_buffer()) without a copy.
 class ByteStream {
   private:
     // Your code here -- add private members as necessary.
 
-    std::deque<char> pipe;
+    //! ring storage, sized to the next power of two at or above the capacity
+    std::string _ring;
+
+    //! `_ring.size() - 1`, maps an absolute byte count onto a ring index
+    size_t _mask;
+
+    //! chunked mode only: the written Buffers, oldest first (the ring is unused)
+    std::deque<Buffer> _chunks{};
+
+    bool _chunked;
 
     size_t _capacity;
 
@@ -30,9 +51,20 @@ class ByteStream {
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    //! Copy as much of `data` as fits onto the end of the ring
+    //! \returns the number of bytes copied
+    size_t copy_in(const std::string_view data);
+
+    //! Copy `len` bytes starting at ring index `pos` into `dst`, wrapping around the end of the ring
+    void copy_out(char *dst, const size_t pos, const size_t len) const;
+
+    //! Views of the next `len` bytes of the stream, in order, without copying them
+    std::deque<std::string_view> peek_views(const size_t len) const;
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    //! \param chunked store written Buffers by reference instead of copying them into a ring
+    ByteStream(const size_t capacity, const bool chunked = false);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -42,6 +74,16 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a Buffer into the stream. In chunked mode, the stream
+    //! shares the Buffer's storage instead of copying it.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
+    //! Read from `fd` straight into the stream's free space (at most one
+    //! [readv(2)](\ref man2::readv) in ring mode)
+    //! \returns the number of bytes accepted into the stream
+    size_t write_from_fd(FileDescriptor &fd);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -59,13 +101,30 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns iovecs pointing into the stream's storage, valid until the next write or pop
+    std::vector<iovec> peek_iovecs(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
+    //! Write up to "len" bytes of the stream to `fd` straight from the stream's storage,
+    //! and pop what was written
+    //! \returns the number of bytes written to `fd`
+    size_t read_into_fd(FileDescriptor &fd, const size_t len = std::numeric_limits<size_t>::max());
+
     //! Read (i.e., copy and then pop) the next "len" bytes of the stream
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read the next "len" bytes of the stream as a list of Buffers
+    //! \note In chunked mode, the Buffers share storage with what was written
+    BufferList read_buffers(const size_t len);
+
+    //! Read the next "len" bytes of the stream as a single Buffer
+    //! \note In chunked mode, this only copies if the bytes span more than one written Buffer
+    Buffer read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -0,0 +1,231 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+unique_ptr<CongestionController> CongestionController::create(const TCPConfig::CongestionControl algorithm,
+                                                              const size_t mss) {
+    switch (algorithm) {
+        case TCPConfig::CongestionControl::Reno:
+            return make_unique<RenoController>(mss);
+        case TCPConfig::CongestionControl::NewReno:
+            return make_unique<NewRenoController>(mss);
+        case TCPConfig::CongestionControl::Cubic:
+            return make_unique<CubicController>(mss);
+        case TCPConfig::CongestionControl::Bbr:
+            return make_unique<BbrController>(mss);
+        case TCPConfig::CongestionControl::None:
+            break;
+    }
+    return make_unique<WindowOnlyController>();
+}
+
+//! The initial window is the one from RFC 5681 section 3.1; the slow start threshold starts out unbounded.
+RenoController::RenoController(const size_t mss)
+    : _mss(mss), _cwnd(min(4 * mss, max(2 * mss, size_t{4380}))), _ssthresh(SIZE_MAX) {}
+
+void RenoController::on_ack(const size_t acked, const size_t /* now_ms */) {
+    if (in_slow_start()) {
+        _cwnd += min(acked, _mss);
+        return;
+    }
+
+    // congestion avoidance: one MSS per window's worth of acknowledged bytes
+    _bytes_acked += acked;
+    if (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void RenoController::on_loss(const size_t in_flight, const size_t /* now_ms */) {
+    _ssthresh = max(in_flight / 2, 2 * _mss);
+    _cwnd = _ssthresh + 3 * _mss;  // the three duplicate ACKs each mean a segment has left the network
+    _bytes_acked = 0;
+}
+
+void RenoController::on_dup_ack() { _cwnd += _mss; }
+
+void RenoController::on_recovery_end() {
+    _cwnd = _ssthresh;
+    _bytes_acked = 0;
+}
+
+void RenoController::on_timeout(const size_t in_flight, const size_t /* now_ms */) {
+    _ssthresh = max(in_flight / 2, 2 * _mss);
+    _cwnd = _mss;
+    _bytes_acked = 0;
+}
+
+//! Deflate the window by the amount of new data acknowledged, adding back one MSS
+//! if at least that much was acknowledged (RFC 6582 section 3.2, step 5).
+bool NewRenoController::on_partial_ack(const size_t acked) {
+    _cwnd = _cwnd > acked ? _cwnd - acked : 0;
+    if (acked >= _mss) {
+        _cwnd += _mss;
+    }
+    _cwnd = max(_cwnd, _mss);
+    return true;
+}
+
+void CubicController::reduce() {
+    const double cwnd = static_cast<double>(_cwnd) / _mss;
+
+    // fast convergence: release bandwidth sooner if the window stopped short of the last maximum
+    _w_max = cwnd < _w_max ? cwnd * (1 + BETA) / 2 : cwnd;
+    _ssthresh = max(static_cast<size_t>(_cwnd * BETA), 2 * _mss);
+    _bytes_acked = 0;
+    _in_epoch = false;
+}
+
+void CubicController::on_ack(const size_t acked, const size_t now_ms) {
+    if (in_slow_start()) {
+        RenoController::on_ack(acked, now_ms);
+        return;
+    }
+
+    const double cwnd = static_cast<double>(_cwnd) / _mss;
+    if (not _in_epoch) {
+        _in_epoch = true;
+        _epoch = now_ms;
+        _w_max = max(_w_max, cwnd);
+        _k = cbrt((_w_max - cwnd) / C);
+        _w_est = cwnd;
+    }
+
+    const double t = static_cast<double>(now_ms - _epoch) / 1000;
+    double target = C * pow(t - _k, 3) + _w_max;
+    target = min(max(target, cwnd), 1.5 * cwnd);
+
+    // the window a Reno sender would have reached by now (RFC 8312 section 4.2)
+    constexpr double alpha = 3 * (1 - BETA) / (1 + BETA);
+    _w_est += alpha * static_cast<double>(acked) / _cwnd;
+    target = max(target, _w_est);
+
+    _cwnd += static_cast<size_t>((target - cwnd) / cwnd * acked);
+}
+
+void CubicController::on_loss(const size_t /* in_flight */, const size_t /* now_ms */) {
+    reduce();
+    _cwnd = _ssthresh + 3 * _mss;
+}
+
+void CubicController::on_timeout(const size_t /* in_flight */, const size_t /* now_ms */) {
+    reduce();
+    _cwnd = _mss;
+}
+
+double BbrController::bandwidth() const {
+    double bw = 0;
+    for (const auto &sample : _bw_samples) {
+        bw = max(bw, sample.second);
+    }
+    return bw;
+}
+
+double BbrController::pacing_gain() const {
+    switch (_mode) {
+        case Mode::Startup:
+            return HIGH_GAIN;
+        case Mode::Drain:
+            return 1 / HIGH_GAIN;
+        case Mode::ProbeBW:
+            // probe for more bandwidth for one round, drain the resulting queue the next, then cruise
+            return _cycle_index == 0 ? 1.25 : _cycle_index == 1 ? 0.75 : 1;
+        case Mode::ProbeRTT:
+            break;
+    }
+    return 1;
+}
+
+void BbrController::enter(const Mode mode, const size_t now_ms) {
+    _mode = mode;
+    _mode_start = now_ms;
+    _cycle_index = 0;
+}
+
+//! Before the first bandwidth sample, the window is the same initial window Reno uses.
+size_t BbrController::window() const {
+    const size_t min_window = 4 * _mss;
+    if (_after_timeout) {
+        return _mss;
+    }
+    if (_mode == Mode::ProbeRTT or _bw_samples.empty()) {
+        return min_window;
+    }
+    const double gain = _mode == Mode::ProbeBW ? 2 : HIGH_GAIN;
+    return max(static_cast<size_t>(gain * bandwidth() * _min_rtt), min_window);
+}
+
+size_t BbrController::pacing_rate() const {
+    if (_bw_samples.empty()) {
+        return 0;
+    }
+    return static_cast<size_t>(pacing_gain() * bandwidth() * 1000);
+}
+
+void BbrController::end_round(const size_t now_ms) {
+    const double bw = static_cast<double>(_delivered - _round_delivered) / (now_ms - _round_start);
+    _round++;
+    _round_start = now_ms;
+    _round_delivered = _delivered;
+
+    _bw_samples.emplace_back(_round, bw);
+    while (_bw_samples.front().first + BW_WINDOW_ROUNDS <= _round) {
+        _bw_samples.pop_front();
+    }
+
+    switch (_mode) {
+        case Mode::Startup:
+            // the pipe is full once three rounds in a row fail to grow the estimate by 25%
+            if (bandwidth() >= _full_bw * 1.25) {
+                _full_bw = bandwidth();
+                _full_bw_rounds = 0;
+            } else if (++_full_bw_rounds >= 3) {
+                enter(Mode::Drain, now_ms);
+            }
+            break;
+        case Mode::Drain:
+            enter(Mode::ProbeBW, now_ms);
+            break;
+        case Mode::ProbeBW:
+            _cycle_index = (_cycle_index + 1) % PROBE_BW_PHASES;
+            break;
+        case Mode::ProbeRTT:
+            break;
+    }
+}
+
+void BbrController::on_ack(const size_t acked, const size_t now_ms) {
+    _after_timeout = false;
+    _delivered += acked;
+    if (not _started) {  // the first acknowledgment starts the clock
+        _started = true;
+        _round_start = now_ms;
+        _round_delivered = _delivered;
+    }
+
+    if (_min_rtt != SIZE_MAX and now_ms >= _round_start + max(_min_rtt, size_t{1})) {
+        end_round(now_ms);
+    }
+
+    if (_mode == Mode::ProbeRTT) {
+        if (now_ms >= _mode_start + max(PROBE_RTT_MS, _min_rtt)) {
+            _min_rtt_stamp = now_ms;
+            enter(_full_bw_rounds >= 3 ? Mode::ProbeBW : Mode::Startup, now_ms);
+        }
+    } else if (_min_rtt != SIZE_MAX and now_ms > _min_rtt_stamp + MIN_RTT_WINDOW_MS) {
+        enter(Mode::ProbeRTT, now_ms);
+    }
+}
+
+void BbrController::on_timeout(const size_t /* in_flight */, const size_t /* now_ms */) { _after_timeout = true; }
+
+void BbrController::on_rtt_sample(const size_t rtt_ms, const size_t now_ms) {
+    if (rtt_ms <= _min_rtt or now_ms > _min_rtt_stamp + MIN_RTT_WINDOW_MS) {
+        _min_rtt = rtt_ms;
+        _min_rtt_stamp = now_ms;
+    }
+}
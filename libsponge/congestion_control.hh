@@ -0,0 +1,207 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include "tcp_config.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+
+//! \brief The congestion-control half of a TCPSender.
+
+//! A CongestionController owns the congestion window: an upper bound, in bytes of
+//! sequence space, on how much the TCPSender may have in flight, in addition to the
+//! receiver's advertised window. The TCPSender reports acknowledgments, loss events
+//! and retransmission timeouts, and reads back window() whenever it fills the window.
+//!
+//! Fast recovery (RFC 5681 section 3.2) is driven by the TCPSender:
+//! on_loss() starts it, on_dup_ack() and on_partial_ack() are called during it, and
+//! on_recovery_end() finishes it. With ECN, on_congestion_mark() reports congestion that cost no loss.
+class CongestionController {
+  public:
+    //! \returns the congestion window, in bytes
+    virtual size_t window() const = 0;
+
+    //! \brief `acked` bytes of new data were acknowledged (outside of fast recovery, or by the acknowledgment
+    //! that ends it, right after on_recovery_end())
+    //! \param[in] now_ms the sender's current time, in milliseconds
+    virtual void on_ack(const size_t acked, const size_t now_ms) = 0;
+
+    //! \brief A loss was detected by duplicate acknowledgments; fast recovery begins
+    //! \param[in] in_flight the number of bytes outstanding when the loss was detected
+    //! \param[in] now_ms the sender's current time, in milliseconds
+    virtual void on_loss(const size_t in_flight, const size_t now_ms) = 0;
+
+    //! \brief Another duplicate acknowledgment arrived during fast recovery
+    virtual void on_dup_ack() {}
+
+    //! \brief An acknowledgment during fast recovery covered some, but not all, of the outstanding data
+    //! \returns `true` to stay in fast recovery (and retransmit the next hole), `false` to end it
+    virtual bool on_partial_ack(const size_t /* acked */) { return false; }
+
+    //! \brief Fast recovery ended
+    virtual void on_recovery_end() {}
+
+    //! \brief The receiver echoed a congestion mark (ECN-Echo): back off as for a loss, with nothing to recover
+    //! \details By default, a loss detected and recovered from at once
+    //! \param[in] in_flight the number of bytes outstanding when the echo arrived
+    //! \param[in] now_ms the sender's current time, in milliseconds
+    virtual void on_congestion_mark(const size_t in_flight, const size_t now_ms) {
+        on_loss(in_flight, now_ms);
+        on_recovery_end();
+    }
+
+    //! \brief The retransmission timer expired
+    //! \param[in] in_flight the number of bytes outstanding when the timer expired
+    //! \param[in] now_ms the sender's current time, in milliseconds
+    virtual void on_timeout(const size_t in_flight, const size_t now_ms) = 0;
+
+    //! \brief A round-trip time was measured (never on a retransmitted segment)
+    virtual void on_rtt_sample(const size_t /* rtt_ms */, const size_t /* now_ms */) {}
+
+    //! \returns the rate, in bytes per second, at which the TCPSender should space out segments (0 for no pacing)
+    virtual size_t pacing_rate() const { return 0; }
+
+    //! \returns the name of the algorithm
+    virtual std::string name() const = 0;
+
+    virtual ~CongestionController() = default;
+
+    //! Construct the controller selected by `algorithm`, for segments of up to `mss` bytes
+    static std::unique_ptr<CongestionController> create(const TCPConfig::CongestionControl algorithm,
+                                                        const size_t mss);
+};
+
+//! \brief No congestion control: only the receiver's window limits the sender
+class WindowOnlyController : public CongestionController {
+  public:
+    size_t window() const override { return SIZE_MAX; }
+    void on_ack(const size_t, const size_t) override {}
+    void on_loss(const size_t, const size_t) override {}
+    void on_timeout(const size_t, const size_t) override {}
+    std::string name() const override { return "none"; }
+};
+
+//! \brief Reno (RFC 5681): slow start, congestion avoidance and fast recovery
+class RenoController : public CongestionController {
+  protected:
+    size_t _mss;            //!< maximum segment size, in bytes
+    size_t _cwnd;           //!< congestion window, in bytes
+    size_t _ssthresh;       //!< slow start threshold, in bytes
+    size_t _bytes_acked{};  //!< bytes acknowledged since the window last grew in congestion avoidance
+
+    //! \returns `true` while the window is below the slow start threshold
+    bool in_slow_start() const { return _cwnd < _ssthresh; }
+
+  public:
+    //! \param[in] mss maximum segment size, in bytes
+    explicit RenoController(const size_t mss);
+
+    size_t window() const override { return _cwnd; }
+    void on_ack(const size_t acked, const size_t now_ms) override;
+    void on_loss(const size_t in_flight, const size_t now_ms) override;
+    void on_dup_ack() override;
+    void on_recovery_end() override;
+    void on_timeout(const size_t in_flight, const size_t now_ms) override;
+    std::string name() const override { return "reno"; }
+};
+
+//! \brief NewReno (RFC 6582): Reno, but a partial acknowledgment keeps the sender in fast recovery
+class NewRenoController : public RenoController {
+  public:
+    using RenoController::RenoController;
+
+    bool on_partial_ack(const size_t acked) override;
+    std::string name() const override { return "newreno"; }
+};
+
+//! \brief CUBIC (RFC 8312): the window grows as a cubic function of the time since the last loss
+class CubicController : public RenoController {
+  private:
+    static constexpr double C = 0.4;     //!< scaling constant of the cubic function
+    static constexpr double BETA = 0.7;  //!< multiplicative decrease factor
+
+    double _w_max{};   //!< window just before the last reduction, in segments
+    double _k{};       //!< time for the cubic function to grow back to _w_max, in seconds
+    double _w_est{};   //!< estimate of the window a Reno sender would have, in segments
+    size_t _epoch{};   //!< time at which the current congestion avoidance epoch began, in milliseconds
+    bool _in_epoch{};  //!< has the current congestion avoidance epoch begun?
+
+    //! Shrink the window by BETA after a loss, remembering where it was
+    void reduce();
+
+  public:
+    using RenoController::RenoController;
+
+    void on_ack(const size_t acked, const size_t now_ms) override;
+    void on_loss(const size_t in_flight, const size_t now_ms) override;
+    void on_timeout(const size_t in_flight, const size_t now_ms) override;
+    std::string name() const override { return "cubic"; }
+};
+
+//! \brief A model-based controller in the style of BBR
+
+//! Instead of reacting to loss, BbrController estimates the bottleneck bandwidth (the
+//! highest delivery rate seen over the last few rounds) and the minimum round-trip time,
+//! paces segments at a multiple of the bandwidth estimate, and caps the data in flight
+//! at a multiple of their product. A round is one minimum RTT of acknowledgments.
+class BbrController : public CongestionController {
+  private:
+    enum class Mode { Startup, Drain, ProbeBW, ProbeRTT };
+
+    static constexpr double HIGH_GAIN = 2.885;          //!< 2/ln(2): doubles the delivery rate every round
+    static constexpr size_t BW_WINDOW_ROUNDS = 10;      //!< rounds over which the bandwidth maximum is kept
+    static constexpr size_t MIN_RTT_WINDOW_MS = 10000;  //!< how long a minimum RTT estimate stays valid
+    static constexpr size_t PROBE_RTT_MS = 200;         //!< time spent with a small window to remeasure the RTT
+    static constexpr size_t PROBE_BW_PHASES = 8;        //!< length of the ProbeBW gain cycle, in rounds
+
+    size_t _mss;                //!< maximum segment size, in bytes
+    Mode _mode{Mode::Startup};  //!< current phase of the state machine
+
+    //! delivery rate samples, in bytes per millisecond, and the round each was taken in
+    std::deque<std::pair<size_t, double>> _bw_samples{};
+    double _full_bw{};         //!< bandwidth estimate when Startup last saw it grow by 25%
+    size_t _full_bw_rounds{};  //!< rounds since then
+
+    size_t _min_rtt{SIZE_MAX};  //!< minimum RTT, in milliseconds
+    size_t _min_rtt_stamp{};    //!< when _min_rtt was measured
+
+    size_t _delivered{};        //!< total bytes acknowledged
+    size_t _round{};            //!< number of rounds completed
+    size_t _round_start{};      //!< when the current round began
+    size_t _round_delivered{};  //!< _delivered when the current round began
+    bool _started{};            //!< has the first round begun?
+
+    size_t _mode_start{};   //!< when the current mode was entered
+    size_t _cycle_index{};  //!< position in the ProbeBW gain cycle
+    bool _after_timeout{};  //!< limit the window to one segment until the next acknowledgment
+
+    //! \returns the bottleneck bandwidth estimate, in bytes per millisecond
+    double bandwidth() const;
+
+    //! \returns the multiple of the bandwidth estimate to pace at
+    double pacing_gain() const;
+
+    //! Close one round: sample the delivery rate and advance the state machine
+    void end_round(const size_t now_ms);
+
+    //! Switch to `mode`, starting it at `now_ms`
+    void enter(const Mode mode, const size_t now_ms);
+
+  public:
+    //! \param[in] mss maximum segment size, in bytes
+    explicit BbrController(const size_t mss) : _mss(mss) {}
+
+    size_t window() const override;
+    void on_ack(const size_t acked, const size_t now_ms) override;
+    void on_loss(const size_t, const size_t) override {}
+    void on_timeout(const size_t in_flight, const size_t now_ms) override;
+    void on_rtt_sample(const size_t rtt_ms, const size_t now_ms) override;
+    size_t pacing_rate() const override;
+    std::string name() const override { return "bbr"; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
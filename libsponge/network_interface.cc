@@ -24,9 +24,7 @@ NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address, cons
     : _ethernet_address(ethernet_address)
     , _ip_address(ip_address)
     , _arp_cache()
-    , _last_query_timestamps()
-    , _waiting_datagrams()
-    , _time_limit_event_center() {
+    , _waiting_datagrams() {
     cerr << "DEBUG: Network interface has Ethernet address " << to_string(_ethernet_address) << " and IP address "
          << ip_address.ip() << "\n";
 }
@@ -51,8 +49,7 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
 
         _frames_out.push(frame);
     } else {
-        if (_last_query_timestamps.find(next_hop_ip) == _last_query_timestamps.end() ||
-            _ms_since_first_tick - _last_query_timestamps[next_hop_ip] >= 5000) {  // broadcast arp requests
+        if (!_timers.pending(ARP_REQUEST_TIMER + next_hop_ip)) {  // broadcast arp requests
             ARPMessage msg;
 
             msg.sender_ethernet_address = _ethernet_address;
@@ -69,7 +66,7 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
 
             _frames_out.push(frame);
 
-            _last_query_timestamps[next_hop_ip] = _ms_since_first_tick;
+            _timers.schedule(ARP_REQUEST_TIMER + next_hop_ip, _timers.now() + ARP_REQUEST_INTERVAL_MS);
         }
 
         // queue the IP datagram, until get arp response
@@ -103,7 +100,7 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         // record
         _arp_cache[msg.sender_ip_address] = msg.sender_ethernet_address;
         // expires in 30 sec
-        _time_limit_event_center.regist_event(_ms_since_first_tick, msg.sender_ip_address);
+        _timers.schedule(msg.sender_ip_address, _timers.now() + ARP_ENTRY_TTL_MS);
         // notify corresponding queued datagram
         auto it = _waiting_datagrams.find(msg.sender_ip_address);
         if (it != _waiting_datagrams.end()) {
@@ -139,10 +136,9 @@ refuse:
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
-    _ms_since_first_tick += ms_since_last_tick;
-
-    auto evictees = _time_limit_event_center.tick_dispatch(_ms_since_first_tick);
-    for (uint32_t ip_addr : evictees) {
-        _arp_cache.erase(ip_addr);
+    for (const auto timer : _timers.advance(_timers.now() + ms_since_last_tick)) {
+        if (timer < ARP_REQUEST_TIMER) {
+            _arp_cache.erase(static_cast<uint32_t>(timer));
+        }
     }
 }
@@ -30,7 +30,7 @@ void Router::add_route(const uint32_t route_prefix,
          << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)") << " on interface " << interface_num << "\n";
 
     uint8_t unused_length = (32 - prefix_length);
-    uint32_t mask = prefix_length == 0 ? 0 : (-1) >> unused_length << unused_length;
+    uint32_t mask = prefix_length == 0 ? 0 : UINT32_MAX >> unused_length << unused_length;
     RouteItem item = {route_prefix, mask, next_hop, interface_num};
     // insert, keeps the decreasing order.
     for (auto it = _routes.begin();; it++) {
@@ -49,10 +49,15 @@ void Router::route_one_datagram(InternetDatagram &dgram) {
             if (dgram.header().ttl == 0 || --dgram.header().ttl == 0) {  // dec ttl
                 return;                                                  // drop
             }
+            AsyncNetworkInterface &interface = _interfaces[rout.interface_num];
+            if (_ecn_marking_threshold > 0 && interface.frames_out().size() >= _ecn_marking_threshold &&
+                dgram.header().ecn() != IPv4Header::ECN_NOT_ECT) {  // the queue is building up
+                dgram.header().set_ecn(IPv4Header::ECN_CE);
+            }
             if (!rout.next_hop.has_value()) {
-                _interfaces[rout.interface_num].send_datagram(dgram, Address::from_ipv4_numeric(dst));
+                interface.send_datagram(dgram, Address::from_ipv4_numeric(dst));
             } else {
-                _interfaces[rout.interface_num].send_datagram(dgram, rout.next_hop.value());
+                interface.send_datagram(dgram, rout.next_hop.value());
             }
             break;
         }
@@ -58,6 +58,9 @@ class Router {
 
     std::vector<RouteItem> _routes{};
 
+    //! mark ECN-capable datagrams once this many frames wait to leave their interface (0: never)
+    size_t _ecn_marking_threshold{0};
+
   public:
     //! Add an interface to the router
     //! \param[in] interface an already-constructed network interface
@@ -76,6 +79,11 @@ class Router {
                    const std::optional<Address> next_hop,
                    const size_t interface_num);
 
+    //! \brief Signal queue build-up by marking datagrams Congestion Experienced (RFC 3168), rather than by loss
+    //! \details An ECN-capable datagram is marked CE when at least `threshold` frames are already queued on the
+    //! interface it goes out of; 0 turns marking off. Other datagrams are forwarded as they are.
+    void set_ecn_marking_threshold(const size_t threshold) { _ecn_marking_threshold = threshold; }
+
     //! Route packets between the interfaces
     void route();
 };
@@ -13,58 +13,103 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 using namespace std;
 
 void StreamReassembler::write_output() {
-    string data;
-    for (size_t c = 0; c < _output.remaining_capacity() && _bitmap[0]; c++) {
-        data += _buf[0];
-        _bitmap.pop_front();
-        _bitmap.push_back(false);
-        _buf.pop_front();
-        _buf.push_back(0);
-        _unassembled_bytes--;
-        _offset++;
+    auto first = _segments.begin();
+    if (first != _segments.end() && first->first == _offset) {
+        _unassembled_bytes -= first->second.size();
+        _offset += _output.write(first->second);
+        _segments.erase(first);
     }
-    if (data.size() > 0)
-        _output.write(data);
-    if (_eof && empty())
+    if (_eof_index.has_value() && _offset == _eof_index.value())
         _output.end_input();
 }
 
 StreamReassembler::StreamReassembler(const size_t capacity)
-    : _buf(capacity, 0)
-    , _bitmap(capacity, false)
-    , _unassembled_bytes(0)
-    , _offset(0)
-    , _eof(false)
-    , _output(capacity)
-    , _capacity(capacity) {}
+    : _unassembled_bytes(0), _offset(0), _output(capacity), _capacity(capacity) {}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    size_t data_index;
-    size_t buf_index;
-    if (index >= _offset) {
-        data_index = 0;
-        buf_index = index - _offset;
+    _substrings_pushed++;
+    if (eof)
+        _eof_index = index + data.size();
+
+    if (in_order(index)) {
+        _fast_path_pushes++;
+        _offset += _output.write(data);
     } else {
-        data_index = _offset - index;
-        buf_index = 0;
+        insert(data, index);
     }
 
-    for (; data_index < data.size() && buf_index < _buf.size(); data_index++, buf_index++) {
-        _buf[buf_index] = data[data_index];
-        if (_bitmap[buf_index] == false)
-            _unassembled_bytes++;
-        _bitmap[buf_index] = true;
-    }
+    write_output();
+}
 
+void StreamReassembler::push_substring(Buffer data, const size_t index, const bool eof) {
+    _substrings_pushed++;
     if (eof)
-        _eof = true;
+        _eof_index = index + data.size();
+
+    if (in_order(index)) {
+        _fast_path_pushes++;
+        _offset += _output.write(move(data));
+    } else {
+        insert(data, index);
+    }
 
     write_output();
 }
 
+void StreamReassembler::insert(const string_view data, const uint64_t index) {
+    // only keep the part of `data` that is new and fits in the window
+    const uint64_t window_end = _output.bytes_read() + _capacity;
+    uint64_t start = max<uint64_t>(index, _offset);
+    uint64_t end = min<uint64_t>(index + data.size(), window_end);
+    if (start >= end) {
+        return;
+    }
+    string merged{data.substr(start - index, end - start)};
+
+    // absorb a preceding segment that overlaps or touches the new one
+    auto it = _segments.upper_bound(start);
+    if (it != _segments.begin()) {
+        auto prev = std::prev(it);
+        const uint64_t prev_end = prev->first + prev->second.size();
+        if (prev_end >= start) {
+            if (prev_end > end) {
+                merged.append(prev->second, end - prev->first, string::npos);
+                end = prev_end;
+            }
+            merged.insert(0, prev->second, 0, start - prev->first);
+            start = prev->first;
+            _unassembled_bytes -= prev->second.size();
+            it = _segments.erase(prev);
+        }
+    }
+
+    // absorb any following segments that overlap or touch it
+    while (it != _segments.end() && it->first <= end) {
+        const uint64_t it_end = it->first + it->second.size();
+        if (it_end > end) {
+            merged.append(it->second, end - it->first, string::npos);
+            end = it_end;
+        }
+        _unassembled_bytes -= it->second.size();
+        it = _segments.erase(it);
+    }
+
+    _unassembled_bytes += merged.size();
+    _segments.emplace_hint(it, start, move(merged));
+}
+
 size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
 
 bool StreamReassembler::empty() const { return _unassembled_bytes == 0; }
+
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    ranges.reserve(_segments.size());
+    for (const auto &[index, data] : _segments) {
+        ranges.emplace_back(index, index + data.size());
+    }
+    return ranges;
+}
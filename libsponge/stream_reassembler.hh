@@ -4,22 +4,40 @@
 #include "byte_stream.hh"
 
 #include <cstdint>
-#include <deque>
-#include <set>
+#include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
   private:
     // Your code here -- add private members as necessary.
+
+    //! Deliver the segment starting at `_offset` (if there is one) to the output stream
     void write_output();
 
-    std::deque<char> _buf;
-    std::deque<bool> _bitmap;
+    //! Clip `data` to the window and merge it into `_segments`
+    void insert(const std::string_view data, const uint64_t index);
+
+    //! Can a substring at `index` go straight to the output stream?
+    bool in_order(const uint64_t index) const { return index == _offset && _segments.empty(); }
+
+    //! Substrings waiting to be assembled, keyed by stream index. The substrings
+    //! never overlap or touch: a newly pushed substring is merged with its neighbours.
+    std::map<uint64_t, std::string> _segments{};
+
     size_t _unassembled_bytes;
-    size_t _offset;
-    bool _eof;
+    size_t _offset;  //!< index of the next byte to be written to the output stream
+
+    //! index just past the last byte of the stream, once a substring with `eof` has been seen
+    std::optional<uint64_t> _eof_index{};
+
+    size_t _substrings_pushed{0};  //!< number of calls to push_substring()
+    size_t _fast_path_pushes{0};   //!< number of those that went straight to the output stream
 
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
@@ -40,6 +58,12 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer.
+    //!
+    //! When the substring is exactly the next part of the stream and nothing is waiting
+    //! to be assembled, the Buffer is handed to the output stream as is (see ByteStream::write(Buffer)).
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -52,6 +76,19 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The substrings waiting to be assembled, as [first index, index past the end) ranges in stream order
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
+
+    //! \name Counters of in-order delivery
+    //!@{
+
+    //! Number of substrings pushed so far
+    size_t substrings_pushed() const { return _substrings_pushed; }
+
+    //! Number of substrings that arrived in order and bypassed reassembly
+    size_t fast_path_pushes() const { return _fast_path_pushes; }
+    //!@}
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -1,5 +1,7 @@
 #include "tcp_connection.hh"
 
+#include "ipv4_header.hh"
+
 #include <iostream>
 
 // Dummy implementation of a TCP connection
@@ -12,6 +14,71 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+uint16_t TCPConnection::advertised_window(const TCPHeader &header) const {
+    size_t window = _receiver.window_size();
+    if (_window_scaling && !header.syn) {  // the window in a SYN is never scaled
+        window >>= _receive_window_scale;
+    }
+    return min(window, size_t{UINT16_MAX});
+}
+
+void TCPConnection::finish_segment(TCPSegment &seg) {
+    TCPHeader &header = seg.header();
+    header.mss.reset();
+    if (header.syn) {
+        header.mss = min(_cfg.mss, size_t{UINT16_MAX});
+    }
+    header.window_scale.reset();
+    if (_window_scaling && header.syn) {
+        header.window_scale = _receive_window_scale;
+    }
+    header.timestamps.reset();
+    if (_timestamps) {
+        header.timestamps.emplace(_sender.timestamp(), header.ack ? _ts_recent.value_or(0) : 0);
+    }
+    if (header.ack) {  // whatever it carries, this acknowledgment covers everything received so far
+        _last_ack_sent = header.ackno;
+        _last_window_sent = _receiver.window_size();
+        _delayed_ack_segments = 0;
+        _timers.cancel(DELAYED_ACK_TIMER);
+    }
+    if (header.syn) {  // an ECN-setup SYN has ECE and CWR set; an ECN-setup SYN/ACK, only ECE
+        header.ece = _ecn;
+        header.cwr = _ecn && !header.ack;
+    } else {
+        header.ece = _ecn && header.ack && _congestion_experienced;
+    }
+    header.sack_permitted = _sack && header.syn;
+    if (_sack && header.ack) {  // as many blocks as fit beside each packet's payload, within the MSS (RFC 6691)
+        const size_t packet = seg.gso_size() > 0 ? seg.gso_size() : seg.payload().size();
+        const size_t room = _sender.max_segment_size() - min(packet, _sender.max_segment_size());
+        size_t blocks = MAX_SACK_BLOCKS;
+        while (blocks > 0 && sack_option_length(blocks) > room) {
+            blocks--;
+        }
+        header.sack_blocks = _receiver.sack_blocks(blocks);
+    }
+    header.fit_options();
+}
+
+//! PAWS (RFC 7323 section 5) drops a segment whose timestamp is older than the one last echoed: with
+//! windows large enough for sequence numbers to wrap, an old duplicate could otherwise look like new data.
+bool TCPConnection::timestamps_received(const TCPSegment &seg) {
+    const auto [value, echo_reply] = seg.header().timestamps.value();
+    if (!seg.header().syn && _ts_recent.has_value() && static_cast<int32_t>(value - _ts_recent.value()) < 0) {
+        return false;
+    }
+
+    // echo the timestamp of the segment that the next acknowledgment is for (RFC 7323 section 4.3)
+    if (seg.header().syn || seg.header().seqno - _last_ack_sent <= 0) {
+        _ts_recent = value;
+    }
+    if (seg.header().ack) {
+        _sender.timestamp_echo_received(echo_reply);
+    }
+    return true;
+}
+
 void TCPConnection::send_control_segment(ETCPControlType Type) {
     _sender.send_empty_segment();
     TCPSegment seg = std::move(_sender.segments_out().front());
@@ -24,7 +91,7 @@ void TCPConnection::send_control_segment(ETCPControlType Type) {
         case ETCPControlType::Acknowledgement:
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
-            seg.header().win = _receiver.window_size();
+            seg.header().win = advertised_window(seg.header());
             break;
         case ETCPControlType::KeepAlive:
             break;
@@ -35,6 +102,7 @@ void TCPConnection::send_control_segment(ETCPControlType Type) {
             break;
     }
 
+    finish_segment(seg);
     _segments_out.push(seg);
 }
 
@@ -45,8 +113,9 @@ void TCPConnection::send_queued_segments() {
         if (_receiver.ackno().has_value()) {
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
-            seg.header().win = _receiver.window_size();
+            seg.header().win = advertised_window(seg.header());
         }
+        finish_segment(seg);
         _segments_out.push(std::move(seg));
     }
 }
@@ -82,6 +151,9 @@ size_t TCPConnection::time_since_last_segment_received() const {
 
 void TCPConnection::segment_received(const TCPSegment &seg) {
     _ms_last_segment_received = _ms_since_first_tick;
+    if (_timers.pending(LINGER_TIMER)) {  // any segment from the peer restarts the linger
+        _timers.schedule(LINGER_TIMER, _ms_last_segment_received + 10 * _cfg.rt_timeout);
+    }
 
     if (seg.header().rst) {  // reset, unclean close
         shutdown();
@@ -98,8 +170,42 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         return;
     }
 
+    if (seg.header().syn) {
+        _sack = _sack && seg.header().sack_permitted;
+        _window_scaling = _window_scaling && seg.header().window_scale.has_value();
+        _send_window_scale = min(seg.header().window_scale.value_or(0), MAX_WINDOW_SCALE);
+        _timestamps = _timestamps && seg.header().timestamps.has_value();
+        _ecn = _ecn && seg.header().ece && seg.header().cwr != seg.header().ack;  // (CWR on a SYN, not a SYN/ACK)
+        _sender.set_ecn(_ecn);
+        if (!_receiver.ackno().has_value()) {  // the MSS excludes options, so leave room for the timestamps
+            const size_t mss = max(min(_cfg.mss, size_t{seg.header().mss.value_or(UINT16_MAX)}), MIN_MSS);
+            _sender.set_max_segment_size(mss - (_timestamps ? TIMESTAMPS_OPTION_LENGTH : 0));
+        }
+    }
+
+    if (_timestamps && seg.header().timestamps.has_value() && !timestamps_received(seg)) {
+        if (seg.length_in_sequence_space() > 0) {  // acknowledge the old duplicate, but otherwise ignore it
+            send_control_segment(ETCPControlType::Acknowledgement);
+        }
+        return;
+    }
+
+    if (_ecn) {  // echo congestion marks until the peer says it has reduced its window
+        if (seg.header().cwr) {
+            _congestion_experienced = false;
+        }
+        if (seg.ecn() == IPv4Header::ECN_CE) {
+            _congestion_experienced = true;
+        }
+    }
+
     // notify receiver
+    const bool in_order = _receiver.ackno().has_value() && seg.header().seqno == _receiver.ackno().value() &&
+                          _receiver.unassembled_bytes() == 0;
     _receiver.segment_received(seg);
+    if (_sack) {  // new data will carry the SACK blocks an acknowledgment would, so leave room for them
+        _sender.set_option_overhead(sack_option_length(_receiver.sack_blocks(MAX_SACK_BLOCKS).size()));
+    }
 
     // fin recv before outgoing stream eof, don't linger
     if (_receiver.stream_out().input_ended() && !_sender.stream_in().eof()) {
@@ -107,13 +213,47 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
 
     // notify sender if ack flag is set
-    _sender.ack_received(seg.header().ackno, seg.header().win);
+    if (_sack && !seg.header().sack_blocks.empty()) {
+        _sender.sack_received(seg.header().sack_blocks);
+    }
+    if (_ecn && seg.header().ece && !seg.header().syn) {
+        _sender.ecn_echo_received();
+    }
+    uint32_t window = seg.header().win;
+    if (_window_scaling && !seg.header().syn) {
+        window <<= _send_window_scale;
+    }
+    _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() == 0);
     _sender.fill_window();  // try fill window
 
     if (!_sender.segments_out().empty()) {  // send data, it will carry an ack
         send_queued_segments();
     } else if (seg.length_in_sequence_space() > 0) {  // send a pure ack segment if no hitchhike
+        acknowledge(seg, in_order && _receiver.unassembled_bytes() == 0);
+    }
+
+    if (local_ended() && _linger_after_streams_finish && !_timers.pending(LINGER_TIMER)) {
+        _timers.schedule(LINGER_TIMER, _ms_last_segment_received + 10 * _cfg.rt_timeout);
+    }
+}
+
+//! Following RFC 5681 section 4.2, a delayed acknowledgment goes out by the second full-sized segment,
+//! and an out-of-order segment, one that fills a hole, or a SYN or FIN is acknowledged right away.
+//! \details A segment is full-sized if it is as large as any the peer has sent (see _rcv_mss), rather than our
+//! own MSS, which the peer's segments may never reach.
+void TCPConnection::acknowledge(const TCPSegment &seg, const bool in_order) {
+    const bool quick_ack = !_cfg.delayed_ack || !in_order || seg.header().syn || seg.header().fin;
+    if (seg.segments_merged() > 1) {  // merged by receive offload: count the segments the peer sent
+        _rcv_mss = max(_rcv_mss, seg.gso_size());
+        _delayed_ack_segments += static_cast<unsigned int>(seg.segments_merged());
+    } else if (seg.payload().size() > 0) {
+        _rcv_mss = max(_rcv_mss, seg.payload().size());
+        _delayed_ack_segments += seg.payload().size() >= _rcv_mss ? 1 : 0;
+    }
+    if (quick_ack || _delayed_ack_segments >= 2) {
         send_control_segment(ETCPControlType::Acknowledgement);
+    } else if (!_timers.pending(DELAYED_ACK_TIMER)) {
+        _timers.schedule(DELAYED_ACK_TIMER, _ms_since_first_tick + _cfg.ack_delay);
     }
 }
 
@@ -139,6 +279,13 @@ size_t TCPConnection::write(const string &data) {
     return size;
 }
 
+size_t TCPConnection::write(Buffer data) {
+    size_t size = _sender.stream_in().write(move(data));
+    _sender.fill_window();
+    send_queued_segments();
+    return size;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     _ms_since_first_tick += ms_since_last_tick;
@@ -152,11 +299,21 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
 
     send_queued_segments();
 
-    if (local_ended() && _linger_after_streams_finish) {
-        if (time_since_last_segment_received() >= 10 * _cfg.rt_timeout) {
+    for (const auto timer : _timers.advance(_ms_since_first_tick)) {
+        if (timer == DELAYED_ACK_TIMER) {
+            send_control_segment(ETCPControlType::Acknowledgement);
+        } else if (timer == LINGER_TIMER) {
             _linger_after_streams_finish = false;
         }
     }
+
+    if (_cfg.persist_timer && _receiver.ackno().has_value() && !_receiver.stream_out().input_ended()) {
+        // announce a window that reopened, with receiver-side silly window avoidance (RFC 1122 section 4.2.3.3)
+        const size_t threshold = min(_sender.max_segment_size(), _cfg.recv_capacity / 2);
+        if (_last_window_sent < threshold && _receiver.window_size() >= threshold) {
+            send_control_segment(ETCPControlType::Acknowledgement);
+        }
+    }
 }
 
 void TCPConnection::end_input_stream() {
@@ -165,11 +322,25 @@ void TCPConnection::end_input_stream() {
     send_queued_segments();
 }
 
+void TCPConnection::cork() { _sender.set_corked(true); }
+
+void TCPConnection::uncork() {
+    _sender.set_corked(false);
+    _sender.fill_window();
+    send_queued_segments();
+}
+
 void TCPConnection::connect() {
     _sender.fill_window();  // default window size is 1, sender will generate exactly a syn to the peer
     send_queued_segments();
 }
 
+TCPConnection::TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {
+    while (_receive_window_scale < MAX_WINDOW_SCALE && (_cfg.recv_capacity >> _receive_window_scale) > UINT16_MAX) {
+        _receive_window_scale++;
+    }
+}
+
 TCPConnection::~TCPConnection() {
     try {
         if (active()) {
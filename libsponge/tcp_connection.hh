@@ -5,6 +5,9 @@
 #include "tcp_receiver.hh"
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
+#include "timer_wheel.hh"
+
+#include <algorithm>
 
 enum class ETCPControlType {
     Synchronous = 1,
@@ -18,7 +21,7 @@ class TCPConnection {
   private:
     TCPConfig _cfg;
     TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -35,6 +38,84 @@ class TCPConnection {
 
     size_t _time_since_last_segment_received{0};
 
+    //! most SACK blocks to put in one segment (all that fit beside a timestamps option)
+    static constexpr size_t MAX_SACK_BLOCKS = 3;
+
+    //! bytes a SACK option with `blocks` blocks takes up, padding included
+    static constexpr size_t sack_option_length(const size_t blocks) { return blocks == 0 ? 0 : 4 + 8 * blocks; }
+
+    //! are selective acknowledgments in use? Offered per TCPConfig::sack, dropped if the peer's SYN doesn't permit them
+    bool _sack{_cfg.sack};
+
+    //! largest shift count allowed by the window scale option
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;
+
+    //! is window scaling in use? Offered per TCPConfig::window_scaling, dropped if the peer's SYN doesn't offer it
+    bool _window_scaling{_cfg.window_scaling};
+
+    //! how far our advertised windows are shifted: just enough for the whole recv_capacity to fit
+    uint8_t _receive_window_scale{0};
+
+    //! how far the peer's advertised windows are shifted
+    uint8_t _send_window_scale{0};
+
+    //! are timestamps in use? Offered per TCPConfig::timestamps, dropped if the peer's SYN doesn't carry them
+    bool _timestamps{_cfg.timestamps};
+
+    //! bytes a timestamps option takes up in every segment, padding included
+    static constexpr size_t TIMESTAMPS_OPTION_LENGTH = 12;
+
+    //! smallest MSS used, whatever the peer's MSS option says: room for the longest options, and some data
+    static constexpr size_t MIN_MSS = 64;
+
+    //! the peer's timestamp to echo back (TS.Recent)
+    std::optional<uint32_t> _ts_recent{};
+
+    //! is ECN in use? Offered per TCPConfig::ecn, dropped unless the peer's SYN offers it too (RFC 3168 section 6.1.1)
+    bool _ecn{_cfg.ecn};
+
+    //! a segment arrived marked CE, and the peer hasn't yet answered our ECN-Echo with CWR
+    bool _congestion_experienced{false};
+
+    //! ackno of the last acknowledgment we sent (Last.ACK.sent)
+    WrappingInt32 _last_ack_sent{0};
+
+    //! receive window, in bytes, as of the last acknowledgment we sent
+    size_t _last_window_sent{_cfg.recv_capacity};
+
+    //! full-sized segments received since we last sent an acknowledgment
+    unsigned int _delayed_ack_segments{0};
+
+    //! the default MSS of RFC 1122: a segment this large is full-sized until a larger one arrives
+    static constexpr size_t DEFAULT_RCV_MSS = 536;
+
+    //! the largest payload the peer has sent in one segment, which is what makes a segment full-sized: the peer's
+    //! MSS, less the options it sends, may be well under ours
+    size_t _rcv_mss{std::min(_cfg.mss, DEFAULT_RCV_MSS)};
+
+    //! timers of the connection (the sender keeps its own), on the clock of _ms_since_first_tick
+    TimerWheel _timers{};
+
+    //! pending while a delayed acknowledgment is owed
+    static constexpr TimerWheel::TimerId DELAYED_ACK_TIMER = 0;
+
+    //! pending while the connection lingers after both streams have finished
+    static constexpr TimerWheel::TimerId LINGER_TIMER = 1;
+
+    //! \returns the `win` field for an outgoing segment
+    uint16_t advertised_window(const TCPHeader &header) const;
+
+    //! fill in the TCP options of an outgoing segment, and note the acknowledgment it carries
+    void finish_segment(TCPSegment &seg);
+
+    //! acknowledge a segment that occupies sequence space, now or (with TCPConfig::delayed_ack) a little later
+    //! \param in_order did the segment arrive at the left edge of the window, with no holes before or after it?
+    void acknowledge(const TCPSegment &seg, const bool in_order);
+
+    //! \brief Apply the timestamps option of an incoming segment
+    //! \returns `false` if PAWS rejects the segment as an old duplicate
+    bool timestamps_received(const TCPSegment &seg);
+
     void send_control_segment(ETCPControlType Type);
 
     void send_queued_segments();
@@ -54,11 +135,25 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write a Buffer to the outbound byte stream, and send it over TCP if possible
+    //! \note With TCPConfig::zero_copy_send, the sent segments share the Buffer's storage
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(Buffer data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Hold back partial segments, so that the writes that follow can share them (like TCP_CORK)
+    void cork();
+
+    //! \brief Send what cork() held back
+    void uncork();
+
+    //! \brief Is the connection holding back partial segments?
+    bool corked() const { return _sender.corked(); }
     //!@}
 
     //! \name "Output" interface for the reader
@@ -81,6 +176,16 @@ class TCPConnection {
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
 
+    //! \name Round-trip time estimates, for monitoring
+    //!@{
+    //! \brief smoothed round-trip time in milliseconds, if any RTT has been measured
+    std::optional<double> smoothed_rtt() const { return _sender.smoothed_rtt(); }
+    //! \brief round-trip time variation in milliseconds
+    double rtt_variation() const { return _sender.rtt_variation(); }
+    //! \brief current retransmission timeout in milliseconds
+    size_t retransmission_timeout() const { return _sender.retransmission_timeout(); }
+    //!@}
+
     //! \name Methods for the owner or operating system to call
     //!@{
 
@@ -90,6 +195,9 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief How soon, in milliseconds, tick() should be called to let out a segment held back by pacing
+    std::optional<size_t> pacing_delay() const { return _sender.pacing_delay(); }
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
@@ -103,7 +211,7 @@ class TCPConnection {
     //!@}
 
     //! Construct a new connection from a configuration
-    explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {}
+    explicit TCPConnection(const TCPConfig &cfg);
 
     //! \name construction and destruction
     //! moving is allowed; copying is disallowed; default construction not possible
@@ -54,7 +54,7 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
-    //! Writes a TCP segment into a UDP payload
+    //! Writes a TCP segment into a UDP payload (split into packets first, with segmentation offload)
     void write(TCPSegment &seg);
 
     //! Access the underlying UDP socket
@@ -10,6 +10,15 @@ struct IPv4Header {
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
 
+    //! \name ECN codepoints (RFC 3168), in the two low-order bits of `tos`
+    //!@{
+    static constexpr uint8_t ECN_MASK = 0b11;     //!< The bits of `tos` that hold the codepoint
+    static constexpr uint8_t ECN_NOT_ECT = 0b00;  //!< Not ECN-capable
+    static constexpr uint8_t ECN_ECT1 = 0b01;     //!< ECN-capable transport, ECT(1)
+    static constexpr uint8_t ECN_ECT0 = 0b10;     //!< ECN-capable transport, ECT(0)
+    static constexpr uint8_t ECN_CE = 0b11;       //!< Congestion experienced
+    //!@}
+
     //! \struct IPv4Header
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -55,6 +64,12 @@ struct IPv4Header {
     //! Length of the payload
     uint16_t payload_length() const;
 
+    //! The ECN codepoint
+    uint8_t ecn() const { return tos & ECN_MASK; }
+
+    //! Set the ECN codepoint, leaving the rest of `tos` alone
+    void set_ecn(const uint8_t codepoint) { tos = static_cast<uint8_t>((tos & ~ECN_MASK) | (codepoint & ECN_MASK)); }
+
     //! [pseudo-header's](\ref rfc::rfc793) contribution to the TCP checksum
     uint32_t pseudo_cksum() const;
 
@@ -48,12 +48,21 @@ class LossyFdAdapter {
     }
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
+    //! \details With segmentation offload, the segment is split first, so that each packet is dropped or not
+    //! on its own rather than the whole burst at once.
     //! \param[in] seg is the packet to either write or drop
     void write(TCPSegment &seg) {
-        if (_should_drop(true)) {
-            return;
+        if (seg.gso_size() == 0) {
+            if (_should_drop(true)) {
+                return;
+            }
+            return _adapter.write(seg);
+        }
+        for (auto &packet : seg.packets()) {
+            if (not _should_drop(true)) {
+                _adapter.write(packet);
+            }
         }
-        return _adapter.write(seg);
     }
 
     //! \name
@@ -0,0 +1,64 @@
+#include "segment_coalescer.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+SegmentCoalescer::SegmentCoalescer(const size_t max_payload) : _max_payload(max_payload) {}
+
+bool SegmentCoalescer::continues_run(const TCPSegment &seg) const {
+    if (not _run_started or _run_payload.size() == 0 or seg.payload().size() == 0 or
+        _run_payload.size() + seg.payload().size() > _max_payload) {
+        return false;
+    }
+
+    const TCPHeader &run = _run.header();
+    const TCPHeader &next = seg.header();
+
+    // only plain data: the flags that need a segment of their own end a run
+    if (run.syn or run.rst or run.urg or run.fin or next.syn or next.rst or next.urg or next.cwr) {
+        return false;
+    }
+
+    return next.seqno == run.seqno + _run_payload.size() and next.sport == run.sport and next.dport == run.dport and
+           next.ack == run.ack and next.ackno == run.ackno and next.win == run.win and next.ece == run.ece and
+           next.mss == run.mss and next.window_scale == run.window_scale and
+           next.sack_permitted == run.sack_permitted and next.timestamps == run.timestamps and
+           next.sack_blocks == run.sack_blocks and seg.ecn() == _run.ecn();
+}
+
+//! \details The merged segment has the header of the run's first segment, but for PSH if any of them had it, and
+//! FIN if the last one did. It records how many segments it was merged from, and the largest of their payloads as
+//! its gso_size(), so that the connection still sees the segments the peer sent.
+void SegmentCoalescer::segment_received(TCPSegment &&seg) {
+    if (continues_run(seg)) {
+        _run.gso_size() = max({_run.gso_size(), _run.payload().size(), seg.payload().size()});
+        _run.segments_merged()++;
+        _run_payload.append(seg.payload());
+        _run.header().psh = _run.header().psh or seg.header().psh;
+        _run.header().fin = seg.header().fin;
+        return;
+    }
+
+    flush();
+    _run_payload = BufferList{seg.payload()};
+    _run = move(seg);
+    _run_started = true;
+}
+
+void SegmentCoalescer::flush() {
+    if (not _run_started) {
+        return;
+    }
+
+    // One copy of the run's payload: the receiver's stream copies each Buffer in anyway, and tcp_benchmark puts
+    // this one at under 5% of the time spent on a bulk transfer with GSO+GRO. (A lone segment isn't copied.)
+    if (_run_payload.buffers().size() > 1) {
+        _run.payload() = Buffer{_run_payload.concatenate()};
+    }
+    _segments_out.push(move(_run));
+    _run = TCPSegment{};
+    _run_payload = BufferList{};
+    _run_started = false;
+}
@@ -0,0 +1,47 @@
+#ifndef SPONGE_LIBSPONGE_SEGMENT_COALESCER_HH
+#define SPONGE_LIBSPONGE_SEGMENT_COALESCER_HH
+
+#include "buffer.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <queue>
+
+//! \brief Merges runs of consecutive inbound segments into one, before they reach a TCPConnection
+//! (generic receive offload)
+//! \details A segment joins the run before it if it carries data that follows on from the run's in sequence
+//! space, with the same ackno, window, options and ECN codepoint, and with no flags but ACK, PSH and FIN
+//! (which ends the run). Anything else starts a new run. The connection then handles a burst of data, and
+//! sends an ACK for it, once rather than per segment.
+class SegmentCoalescer {
+  private:
+    //! most payload bytes in a merged segment
+    size_t _max_payload;
+
+    //! the run being built: its first segment, with the payloads of the whole run
+    TCPSegment _run{};
+    BufferList _run_payload{};
+    bool _run_started{false};
+
+    //! segments to pass on, in order
+    std::queue<TCPSegment> _segments_out{};
+
+    //! can `seg` be added to the run?
+    bool continues_run(const TCPSegment &seg) const;
+
+  public:
+    //! \param[in] max_payload is the most payload bytes to merge into one segment
+    explicit SegmentCoalescer(const size_t max_payload = TCPConfig::MAX_OFFLOAD_SIZE);
+
+    //! \brief Take in a segment, merging it with those before it where possible
+    void segment_received(TCPSegment &&seg);
+
+    //! \brief Pass on the run being built (call after the last segment of a burst)
+    void flush();
+
+    //! \brief Merged segments ready to be passed on
+    std::queue<TCPSegment> &segments_out() { return _segments_out; }
+};
+
+#endif  // SPONGE_LIBSPONGE_SEGMENT_COALESCER_HH
@@ -11,15 +11,42 @@
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
-    static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
-    static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
-    static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
-
-    uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
-    size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
-    size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    static constexpr size_t DEFAULT_CAPACITY = 64000;    //!< Default capacity
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;     //!< Conservative max payload size for real Internet
+    static constexpr uint16_t TIMEOUT_DFLT = 1000;       //!< Default re-transmit timeout is 1 second
+    static constexpr unsigned MAX_RETX_ATTEMPTS = 8;     //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t MIN_TIMEOUT_DFLT = 10;     //!< Default lower bound of an adaptive timeout
+    static constexpr uint16_t MAX_TIMEOUT_DFLT = 60000;  //!< Default upper bound of an adaptive timeout
+    static constexpr uint16_t ACK_DELAY_DFLT = 40;       //!< Default longest delay of a delayed ACK
+    static constexpr size_t MAX_OFFLOAD_SIZE = 65536;    //!< Largest payload of a segment left for the adapter to split
+
+    //! Congestion control algorithms available to the TCPSender (see CongestionController)
+    enum class CongestionControl { None, Reno, NewReno, Cubic, Bbr };
+
+    uint16_t rt_timeout = TIMEOUT_DFLT;          //!< Initial value of the retransmission timeout, in milliseconds
+    bool adaptive_rto = false;                   //!< Timeout from RTT samples ([RFC 6298](\ref rfc::rfc6298))
+    uint16_t rt_timeout_min = MIN_TIMEOUT_DFLT;  //!< Lower bound of the adaptive timeout, in milliseconds
+    uint16_t rt_timeout_max = MAX_TIMEOUT_DFLT;  //!< Upper bound of the adaptive timeout and its backoff, in ms
+    size_t recv_capacity = DEFAULT_CAPACITY;     //!< Receive capacity, in bytes
+    size_t send_capacity = DEFAULT_CAPACITY;     //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    bool zero_copy_send = false;  //!< Outbound stream keeps written Buffers instead of copying them (see ByteStream)
+    CongestionControl congestion_control = CongestionControl::None;  //!< Congestion control algorithm of the sender
+    bool sack = false;  //!< Offer selective acknowledgments (RFC 2018), and use them if the peer does too
+    bool window_scaling = false;  //!< Offer window scaling (RFC 7323), so that a recv_capacity over 64 KiB is usable
+    bool timestamps = false;  //!< Offer timestamps (RFC 7323): an RTT sample per ACK, and protection from old segments
+    bool delayed_ack = false;  //!< Acknowledge every second full-sized segment, or after ack_delay, not every segment
+    uint16_t ack_delay = ACK_DELAY_DFLT;  //!< Longest delay of a delayed ACK, in milliseconds
+    bool nagle = false;  //!< Hold back a partial segment while earlier data is unacknowledged (Nagle's algorithm)
+    size_t mss = MAX_PAYLOAD_SIZE;  //!< Largest payload per segment, also advertised to the peer in the MSS option
+    bool mtu_probing = false;  //!< Start at MAX_PAYLOAD_SIZE and probe for the path's room for up to mss (RFC 4821)
+    bool pacing = false;  //!< Space segments out with a token bucket, even if congestion control doesn't ask to
+    size_t pacing_rate = 0;  //!< Pacing rate in bytes per second (0: from the window and the smoothed RTT)
+    bool persist_timer = false;  //!< Probe a zero window on a backed-off persist timer, and announce one reopening
+    bool rack_tlp = false;  //!< Detect loss by send time and probe for lost tails (RACK-TLP, RFC 8985)
+    bool ecn = false;  //!< Offer ECN (RFC 3168): send data ECN-capable, and back off from congestion marks as from loss
+    bool segmentation_offload = false;  //!< Send segments of up to MAX_OFFLOAD_SIZE for the adapter to split by mss
+    bool receive_offload = false;  //!< Merge bursts of inbound segments before TCP sees them (see SegmentCoalescer)
 };
 
 //! Config for classes derived from FdAdapter
@@ -22,7 +22,9 @@ ParseResult TCPHeader::parse(NetParser &p) {
     doff = p.u8() >> 4;              // data offset
 
     const uint8_t fl_b = p.u8();                  // byte including flags
-    urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
+    cwr = static_cast<bool>(fl_b & 0b1000'0000);  // binary literals and ' digit separator since C++14!!!
+    ece = static_cast<bool>(fl_b & 0b0100'0000);
+    urg = static_cast<bool>(fl_b & 0b0010'0000);
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
     rst = static_cast<bool>(fl_b & 0b0000'0100);
@@ -37,14 +39,167 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
-
     if (p.error()) {
         return p.get_error();
     }
 
-    return ParseResult::NoError;
+    return parse_options(p, doff * 4 - TCPHeader::LENGTH);
+}
+
+//! Option kinds, from the IANA "TCP Option Kind Numbers" registry
+enum TCPOptionKind : uint8_t {
+    END = 0,
+    NOP = 1,
+    MSS = 2,
+    WINDOW_SCALE = 3,
+    SACK_PERMITTED = 4,
+    SACK = 5,
+    TIMESTAMPS = 8
+};
+
+//! \details Unknown options are skipped. An option that runs past the end of the header makes
+//! the whole header malformed.
+ParseResult TCPHeader::parse_options(NetParser &p, size_t length) {
+    mss.reset();
+    window_scale.reset();
+    sack_permitted = false;
+    timestamps.reset();
+    sack_blocks.clear();
+
+    while (length > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        length--;
+        if (kind == END) {
+            break;
+        }
+        if (kind == NOP) {
+            continue;
+        }
+
+        if (length == 0) {
+            return ParseResult::HeaderTooShort;
+        }
+        const uint8_t option_length = p.u8();
+        length--;
+        if (option_length < 2 or option_length - 2u > length) {
+            return ParseResult::HeaderTooShort;
+        }
+        const size_t body_length = option_length - 2u;
+        length -= body_length;
+
+        switch (kind) {
+            case MSS:
+                if (body_length != 2) {
+                    return ParseResult::HeaderTooShort;
+                }
+                mss = p.u16();
+                break;
+            case WINDOW_SCALE:
+                if (body_length != 1) {
+                    return ParseResult::HeaderTooShort;
+                }
+                window_scale = p.u8();
+                break;
+            case SACK_PERMITTED:
+                sack_permitted = true;
+                p.remove_prefix(body_length);
+                break;
+            case TIMESTAMPS: {
+                if (body_length != 8) {
+                    return ParseResult::HeaderTooShort;
+                }
+                const uint32_t value = p.u32();
+                const uint32_t echo_reply = p.u32();
+                timestamps.emplace(value, echo_reply);
+                break;
+            }
+            case SACK:
+                if (body_length % 8 != 0) {
+                    return ParseResult::HeaderTooShort;
+                }
+                for (size_t i = 0; i < body_length; i += 8) {
+                    const WrappingInt32 left{p.u32()};
+                    const WrappingInt32 right{p.u32()};
+                    sack_blocks.emplace_back(left, right);
+                }
+                break;
+            default:
+                p.remove_prefix(body_length);
+                break;
+        }
+    }
+
+    // skip the padding after an END option
+    p.remove_prefix(length);
+
+    return p.get_error();
+}
+
+vector<string> TCPHeader::encoded_options() const {
+    vector<string> options;
+
+    if (mss.has_value()) {
+        string option;
+        NetUnparser::u8(option, MSS);
+        NetUnparser::u8(option, 4);
+        NetUnparser::u16(option, mss.value());
+        options.push_back(move(option));
+    }
+
+    if (window_scale.has_value()) {
+        string option;
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, WINDOW_SCALE);
+        NetUnparser::u8(option, 3);
+        NetUnparser::u8(option, window_scale.value());
+        options.push_back(move(option));
+    }
+
+    if (sack_permitted) {
+        string option;
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, SACK_PERMITTED);
+        NetUnparser::u8(option, 2);
+        options.push_back(move(option));
+    }
+
+    if (timestamps.has_value()) {
+        string option;
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, TIMESTAMPS);
+        NetUnparser::u8(option, 10);
+        NetUnparser::u32(option, timestamps->first);
+        NetUnparser::u32(option, timestamps->second);
+        options.push_back(move(option));
+    }
+
+    if (not sack_blocks.empty()) {
+        string option;
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, NOP);
+        NetUnparser::u8(option, SACK);
+        NetUnparser::u8(option, static_cast<uint8_t>(2 + 8 * sack_blocks.size()));
+        for (const auto &[left, right] : sack_blocks) {
+            NetUnparser::u32(option, left.raw_value());
+            NetUnparser::u32(option, right.raw_value());
+        }
+        options.push_back(move(option));
+    }
+
+    return options;
+}
+
+void TCPHeader::fit_options() {
+    size_t length = 0;
+    for (const auto &option : encoded_options()) {
+        if (length + option.size() > MAX_OPTIONS_LENGTH) {
+            break;
+        }
+        length += option.size();
+    }
+    doff = (LENGTH + length) / 4;
 }
 
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
@@ -63,8 +218,9 @@ string TCPHeader::serialize() const {
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
     NetUnparser::u8(ret, doff << 4);           // data offset
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+    const uint8_t fl_b = (cwr ? 0b1000'0000 : 0) | (ece ? 0b0100'0000 : 0) | (urg ? 0b0010'0000 : 0) |
+                         (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) | (rst ? 0b0000'0100 : 0) |
+                         (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
     NetUnparser::u8(ret, fl_b);  // flags
     NetUnparser::u16(ret, win);  // window size
 
@@ -72,7 +228,15 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options, in order, as long as they fit in the advertised size
+    for (const auto &option : encoded_options()) {
+        if (ret.size() + option.size() > 4 * doff) {
+            break;
+        }
+        ret.append(option);
+    }
+
+    ret.resize(4 * doff);  // expand header to advertised size (padding with END options)
 
     return ret;
 }
@@ -85,24 +249,33 @@ string TCPHeader::to_string() const {
        << "TCP seqno: " << seqno << '\n'
        << "TCP ackno: " << ackno << '\n'
        << "TCP doff: " << +doff << '\n'
-       << "Flags: urg: " << urg << " ack: " << ack << " psh: " << psh << " rst: " << rst << " syn: " << syn
-       << " fin: " << fin << '\n'
+       << "Flags: cwr: " << cwr << " ece: " << ece << " urg: " << urg << " ack: " << ack << " psh: " << psh
+       << " rst: " << rst << " syn: " << syn << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP MSS: " << (mss.has_value() ? std::to_string(mss.value()) : "none") << '\n'
+       << "TCP window scale: " << (window_scale.has_value() ? std::to_string(window_scale.value()) : "none") << '\n'
+       << "TCP SACK permitted: " << sack_permitted << '\n';
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << timestamps->first << " echo " << timestamps->second << '\n';
+    }
+    for (const auto &[left, right] : sack_blocks) {
+        ss << "TCP SACK block: " << left << " - " << right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << (ece ? "E" : "") << (cwr ? "C" : "") << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
     return ss.str();
 }
 
 bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
-    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
-           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && cwr == other.cwr && ece == other.ece &&
+           urg == other.urg && ack == other.ack && psh == other.psh && rst == other.rst && syn == other.syn &&
+           fin == other.fin && win == other.win && uptr == other.uptr;
 }
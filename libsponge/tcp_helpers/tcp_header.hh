@@ -4,10 +4,17 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Options are carried in the `4 * doff - LENGTH` bytes after the fixed header. Options that
+//! don't fit in that room are left out when serializing; fit_options() makes room for all of them.
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;              //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< The most option bytes a header can hold
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -20,9 +27,9 @@ struct TCPHeader {
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |                    Acknowledgment Number                      |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //!  |  Data |           |U|A|P|R|S|F|                               |
-    //!  | Offset| Reserved  |R|C|S|S|Y|I|            Window             |
-    //!  |       |           |G|K|H|T|N|N|                               |
+    //!  |  Data |       |C|E|U|A|P|R|S|F|                               |
+    //!  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+    //!  |       |       |R|E|G|K|H|T|N|N|                               |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |           Checksum            |         Urgent Pointer        |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -39,6 +46,8 @@ struct TCPHeader {
     WrappingInt32 seqno{0};     //!< sequence number
     WrappingInt32 ackno{0};     //!< ack number
     uint8_t doff = LENGTH / 4;  //!< data offset
+    bool cwr = false;           //!< congestion window reduced flag (RFC 3168)
+    bool ece = false;           //!< ECN-echo flag (RFC 3168)
     bool urg = false;           //!< urgent flag
     bool ack = false;           //!< ack flag
     bool psh = false;           //!< push flag
@@ -50,6 +59,28 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+
+    //! Maximum segment size option: the most payload the sender can take in one segment (only meaningful on a SYN)
+    std::optional<uint16_t> mss{};
+
+    //! Window scale option: the shift count for the sender's windows (only meaningful on a SYN)
+    std::optional<uint8_t> window_scale{};
+
+    //! SACK-permitted option (only meaningful on a SYN)
+    bool sack_permitted = false;
+
+    //! Timestamps option: the sender's clock (TSval) and the most recent timestamp it received (TSecr)
+    std::optional<std::pair<uint32_t, uint32_t>> timestamps{};
+
+    //! SACK option: blocks of data received out of order, each [left edge, right edge)
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> sack_blocks{};
+    //!@}
+
+    //! Set `doff` to make room for every option (at most MAX_OPTIONS_LENGTH bytes of them)
+    void fit_options();
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
@@ -63,6 +94,13 @@ struct TCPHeader {
     std::string summary() const;
 
     bool operator==(const TCPHeader &other) const;
+
+  private:
+    //! Each option, encoded and padded with NOPs to a multiple of four bytes
+    std::vector<std::string> encoded_options() const;
+
+    //! Parse the options in the `length` bytes following the fixed header
+    ParseResult parse_options(NetParser &p, size_t length);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_HEADER_HH
@@ -3,11 +3,14 @@
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
+#include "util.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <stdexcept>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -22,6 +25,8 @@ using namespace std;
 //! and the TCP segment read from the wire includes a SYN, this function clears the
 //! `_listen` flag and records the source and destination addresses and port numbers
 //! from the TCP header; it uses this information to filter future reads.
+//!
+//! The segment keeps the datagram's ECN codepoint, so that the TCPConnection can see congestion marks.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
 optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram) {
     // is the IPv4 datagram for us?
@@ -67,21 +72,83 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
+    tcp_seg.ecn() = ip_dgram.header().ecn();
     return tcp_seg;
 }
 
-//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
+//! Takes a TCP segment, sets port numbers as necessary, and wraps it in IPv4 datagrams
+//! with the segment's ECN codepoint
+//! \details A segment with a TCPSegment::gso_size() is split into packets of that much payload first
+//! (segmentation offload), as TCPSegment::packets() describes. Their payloads are slices of the segment's, not
+//! copies. The TCP header is serialized once: each packet copies it, patches in its seqno and flags, and
+//! checksums it along with its own slice of the payload.
 //! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+//! \returns the datagrams to send, in order
+vector<InternetDatagram> TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     // set the port numbers in the TCP segment
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
 
+    vector<InternetDatagram> ip_dgrams;
+    if (seg.gso_size() == 0 || seg.payload().size() <= seg.gso_size()) {
+        ip_dgrams.push_back(wrap_packet(seg));
+        return ip_dgrams;
+    }
+
+    TCPHeader header = seg.header();
+    header.syn = header.cwr = header.fin = false;
+    header.cksum = 0;
+    const string header_template = header.serialize();
+    const uint8_t flags_template = header_template[13];
+
+    ip_dgrams.reserve((seg.payload().size() + seg.gso_size() - 1) / seg.gso_size());
+    WrappingInt32 seqno = seg.header().seqno;
+    Buffer rest = seg.payload();
+    for (bool first = true; rest.size() > 0; first = false) {
+        Buffer slice = rest;
+        slice.remove_suffix(rest.size() - min(rest.size(), seg.gso_size()));
+        rest.remove_prefix(slice.size());
+        const bool syn = first && seg.header().syn;
+        const bool cwr = first && seg.header().cwr;
+        const bool fin = seg.header().fin && rest.size() == 0;
+
+        string tcp_header = header_template;
+        const uint32_t raw_seqno = seqno.raw_value();
+        for (size_t i = 0; i < 4; i++) {  // bytes 4-7: seqno
+            tcp_header[4 + i] = static_cast<char>(raw_seqno >> (24 - 8 * i));
+        }
+        tcp_header[13] = static_cast<char>(flags_template | (cwr ? 0b1000'0000 : 0) | (syn ? 0b0000'0010 : 0) |
+                                           (fin ? 0b0000'0001 : 0));  // byte 13: flags
+
+        InternetDatagram ip_dgram = datagram_for(seg.ecn(), tcp_header.size() + slice.size());
+        InternetChecksum check(ip_dgram.header().pseudo_cksum());
+        check.add(tcp_header);
+        check.add(slice);
+        const uint16_t cksum = check.value();
+        tcp_header[16] = static_cast<char>(cksum >> 8);  // bytes 16-17: checksum
+        tcp_header[17] = static_cast<char>(cksum);
+
+        ip_dgram.payload().append(Buffer{move(tcp_header)});
+        ip_dgram.payload().append(slice);
+        ip_dgrams.push_back(move(ip_dgram));
+
+        seqno = seqno + slice.size() + (syn ? 1 : 0);
+    }
+    return ip_dgrams;
+}
+
+InternetDatagram TCPOverIPv4Adapter::datagram_for(const uint8_t ecn, const size_t tcp_length) const {
     // create an Internet Datagram and set its addresses and length
     InternetDatagram ip_dgram;
     ip_dgram.header().src = config().source.ipv4_numeric();
     ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + tcp_length;
+    ip_dgram.header().set_ecn(ecn);  // ECT, if the sender made the segment ECN-capable
+    return ip_dgram;
+}
+
+InternetDatagram TCPOverIPv4Adapter::wrap_packet(const TCPSegment &seg) const {
+    InternetDatagram ip_dgram = datagram_for(seg.ecn(), seg.header().doff * 4 + seg.payload().size());
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
@@ -6,14 +6,28 @@
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
+  private:
+    //! a datagram to the peer, with no payload yet, for `tcp_length` bytes of TCP segment
+    InternetDatagram datagram_for(const uint8_t ecn, const size_t tcp_length) const;
+
+    //! wrap a segment that is one packet
+    InternetDatagram wrap_packet(const TCPSegment &seg) const;
+
   public:
+    static constexpr size_t MTU = 1500;  //!< Largest datagram sent, in bytes (that of an Ethernet link)
+
+    //! \brief The largest TCP payload that fits in an MTU-sized datagram with option-free headers
+    static constexpr size_t mss() { return MTU - IPv4Header::LENGTH - TCPHeader::LENGTH; }
+
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
-    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+    std::vector<InternetDatagram> wrap_tcp_in_ip(TCPSegment &seg);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
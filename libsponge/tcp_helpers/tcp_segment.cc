@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <variant>
 
 using namespace std;
@@ -26,6 +27,34 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+//! \details The packets' payloads are slices of the segment's, not copies.
+vector<TCPSegment> TCPSegment::packets() const {
+    if (_gso_size == 0 || _payload.size() <= _gso_size) {
+        TCPSegment packet = *this;
+        packet._gso_size = 0;
+        return {packet};
+    }
+
+    vector<TCPSegment> ret;
+    ret.reserve((_payload.size() + _gso_size - 1) / _gso_size);
+    TCPSegment packet;
+    packet._header = _header;
+    packet._ecn = _ecn;
+    Buffer rest = _payload;
+    while (rest.size() > 0) {
+        packet._payload = rest;
+        packet._payload.remove_suffix(rest.size() - min(rest.size(), _gso_size));
+        rest.remove_prefix(packet._payload.size());
+        packet._header.fin = _header.fin && rest.size() == 0;
+        ret.push_back(packet);
+
+        packet._header.seqno = packet._header.seqno + packet.length_in_sequence_space();
+        packet._header.syn = false;
+        packet._header.cwr = false;
+    }
+    return ret;
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
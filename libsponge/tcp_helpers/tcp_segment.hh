@@ -5,12 +5,16 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    uint8_t _ecn{0};
+    size_t _gso_size{0};
+    size_t _segments_merged{1};
 
   public:
     //! \brief Parse the segment from a string
@@ -26,8 +30,28 @@ class TCPSegment {
 
     const Buffer &payload() const { return _payload; }
     Buffer &payload() { return _payload; }
+
+    //! \brief ECN codepoint of the IP datagram that carries the segment (see IPv4Header::ECN_MASK)
+    //! \note Not part of the segment itself: TCPOverIPv4Adapter copies it to and from the datagram's `tos`
+    uint8_t ecn() const { return _ecn; }
+    uint8_t &ecn() { return _ecn; }
+
+    //! \brief With segmentation offload, the most payload bytes per packet (0: the segment is one packet)
+    //! \note Not part of the segment itself: TCPOverIPv4Adapter splits the segment into packets this size.
+    //! On a segment merged by receive offload, it is the largest payload of the segments merged.
+    size_t gso_size() const { return _gso_size; }
+    size_t &gso_size() { return _gso_size; }
+
+    //! \brief With receive offload, how many segments this one was merged from (see SegmentCoalescer)
+    size_t segments_merged() const { return _segments_merged; }
+    size_t &segments_merged() { return _segments_merged; }
     //!@}
 
+    //! \brief The packets the segment stands for: with a gso_size(), one per gso_size() bytes of payload, each with
+    //! the segment's header but for its own seqno, and with SYN and CWR only on the first and FIN only on the last
+    //! \note Otherwise, just the segment itself
+    std::vector<TCPSegment> packets() const;
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
@@ -5,9 +5,11 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
+#include <poll.h>
 #include <stdexcept>
 #include <string>
 #include <sys/socket.h>
@@ -19,13 +21,29 @@
 using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
+static constexpr size_t MAX_READ_BURST = 64;  // datagrams read in a row before the other rules get a turn
+
+//! \returns whether `fd` can be read from without blocking
+static bool readable(const FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & POLLIN);
+}
 
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        const bool corked = _corked;  // set by the owner thread
+        if (corked and not _tcp.value().corked()) {
+            _tcp.value().cork();
+        } else if (not corked and _tcp.value().corked()) {
+            _tcp.value().uncork();
+        }
+
+        // wake up early if pacing is holding back a segment
+        const size_t timeout = min(TCP_TICK_MS, _tcp.value().pacing_delay().value_or(TCP_TICK_MS));
+        auto ret = _eventloop.wait_next_event(static_cast<int>(timeout));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -53,6 +71,9 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    if (config.receive_offload) {
+        _coalescer.emplace();
+    }
 
     // Set up the event loop
 
@@ -73,12 +94,29 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     //    given to underlying datagram socket)
 
     // rule 1: read from filtered packet stream and dump into TCPConnection
+    // (with receive offload, the whole burst waiting to be read, merged where it can be)
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            if (not _coalescer) {
+                                auto seg = _datagram_adapter.read();
+                                if (seg) {
+                                    _tcp->segment_received(move(seg.value()));
+                                }
+                            } else {
+                                size_t reads = 0;
+                                do {
+                                    auto seg = _datagram_adapter.read();
+                                    if (seg) {
+                                        _coalescer->segment_received(move(seg.value()));
+                                    }
+                                } while (++reads < MAX_READ_BURST and readable(_datagram_adapter));
+                                _coalescer->flush();
+
+                                while (not _coalescer->segments_out().empty()) {
+                                    _tcp->segment_received(_coalescer->segments_out().front());
+                                    _coalescer->segments_out().pop();
+                                }
                             }
 
                             // debugging output:
@@ -96,9 +134,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
-            const auto amount_written = _tcp->write(move(data));
+            const auto amount_written = _tcp->write(Buffer{move(data)});
             if (amount_written != len) {
                 throw runtime_error("TCPConnection::write() accepted less than advertised length");
             }
@@ -128,10 +166,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // Write from the inbound_stream into
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
-            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
-            inbound.pop_output(bytes_written);
+            inbound.read_into_fd(_thread_data, 65536);
 
             if (inbound.eof() or inbound.error()) {
                 _thread_data.shutdown(SHUT_WR);
@@ -290,6 +325,9 @@ CS144TCPSocket::CS144TCPSocket() : TCPOverIPv4SpongeSocket(TCPOverIPv4OverTunFdA
 void CS144TCPSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.mss = TCPOverIPv4Adapter::mss();
+    tcp_config.mtu_probing = true;
+    tcp_config.segmentation_offload = true;
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {"169.254.144.9", to_string(uint16_t(random_device()()))};
@@ -321,6 +359,9 @@ FullStackSocket::FullStackSocket()
 void FullStackSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.mss = TCPOverIPv4Adapter::mss();
+    tcp_config.mtu_probing = true;
+    tcp_config.segmentation_offload = true;
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {LOCAL_TAP_IP_ADDRESS, to_string(uint16_t(random_device()()))};
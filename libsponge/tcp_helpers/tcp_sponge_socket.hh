@@ -6,6 +6,7 @@
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
 #include "network_interface.hh"
+#include "segment_coalescer.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
 #include "tuntap_adapter.hh"
@@ -34,6 +35,9 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! TCP state machine
     std::optional<TCPConnection> _tcp{};
 
+    //! Merges inbound segments on their way to the TCPConnection (TCPConfig::receive_offload)
+    std::optional<SegmentCoalescer> _coalescer{};
+
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
@@ -57,6 +61,8 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    std::atomic_bool _corked{false};  //!< Has the owner asked to hold back partial segments?
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -66,6 +72,13 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! or else may wait foreever for remote peer to close the TCP connection.
     void wait_until_closed();
 
+    //! Hold back partial segments, so that the writes that follow can share them (like TCP_CORK)
+    //! \note Takes effect on the TCPConnection thread, within one tick
+    void cork() { _corked = true; }
+
+    //! Send what cork() held back
+    void uncork() { _corked = false; }
+
     //! Connect using the specified configurations; blocks until connect succeeds or fails
     void connect(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
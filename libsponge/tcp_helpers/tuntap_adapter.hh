@@ -27,8 +27,12 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Creates IPv4 datagrams from a TCP segment and writes them to the TUN device
+    void write(TCPSegment &seg) {
+        for (const auto &ip_dgram : wrap_tcp_in_ip(seg)) {
+            _tun.write(ip_dgram.serialize());
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
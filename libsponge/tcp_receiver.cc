@@ -29,8 +29,14 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     }
 
     if (_isn.has_value()) {
-        _reassembler.push_substring(seg.payload().copy(), index, seg.header().fin);
+        // hand over the payload's Buffer (a refcount bump, not a copy); at most the part
+        // that has to wait for reassembly, or the copy into the inbound stream, touches the bytes
+        const bool out_of_order = index > stream_out().bytes_written() && seg.payload().size() > 0;
+        _reassembler.push_substring(seg.payload(), index, seg.header().fin);
         _last_reassembled = index;
+        if (out_of_order) {
+            _latest_out_of_order = index;
+        }
     }
 }
 
@@ -49,3 +55,32 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 }
 
 size_t TCPReceiver::window_size() const { return _capacity - stream_out().buffer_size(); }
+
+vector<pair<WrappingInt32, WrappingInt32>> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<pair<WrappingInt32, WrappingInt32>> blocks;
+    if (!_isn.has_value()) {
+        return blocks;
+    }
+
+    const auto ranges = _reassembler.unassembled_ranges();
+    const auto to_block = [&](const pair<uint64_t, uint64_t> &range) {
+        // stream index + 1 is the absolute seqno (the SYN comes first)
+        return make_pair(wrap(range.first + 1, _isn.value()), wrap(range.second + 1, _isn.value()));
+    };
+    const auto is_latest = [&](const pair<uint64_t, uint64_t> &range) {
+        return _latest_out_of_order.has_value() && range.first <= _latest_out_of_order.value() &&
+               _latest_out_of_order.value() < range.second;
+    };
+
+    for (const auto &range : ranges) {
+        if (is_latest(range) && blocks.size() < max_blocks) {
+            blocks.push_back(to_block(range));
+        }
+    }
+    for (const auto &range : ranges) {
+        if (!is_latest(range) && blocks.size() < max_blocks) {
+            blocks.push_back(to_block(range));
+        }
+    }
+    return blocks;
+}
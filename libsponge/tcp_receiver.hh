@@ -7,6 +7,8 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -24,6 +26,9 @@ class TCPReceiver {
 
     uint64_t _last_reassembled;
 
+    //! stream index of the most recent payload that arrived ahead of the stream
+    std::optional<uint64_t> _latest_out_of_order{};
+
   public:
     //! \brief Construct a TCP receiver
     //!
@@ -52,11 +57,25 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief SACK blocks (RFC 2018) describing the data held for reassembly
+    //!
+    //! The block holding the most recently received out-of-order data comes first,
+    //! followed by the others in sequence order.
+    //! \param max_blocks the most blocks to return
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> sack_blocks(const size_t max_blocks) const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief number of segment payloads handed to the reassembler, and how many of those arrived in order
+    //! (see StreamReassembler::fast_path_pushes())
+    //!@{
+    size_t payloads_received() const { return _reassembler.substrings_pushed(); }
+    size_t in_order_payloads() const { return _reassembler.fast_path_pushes(); }
+    //!@}
+
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
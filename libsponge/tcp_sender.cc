@@ -1,7 +1,10 @@
 #include "tcp_sender.hh"
 
+#include "ipv4_header.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 // Dummy implementation of a TCP sender
@@ -19,28 +22,130 @@ void TCPSender::send_segment(TCPSegment seg) {
         return;
     }
     seg.header().seqno = wrap(_next_seqno, _isn);
-    _segments_out.push(seg);                  // push to sender buffer
-    _unacknowledged_segments.push_back(seg);  // start track
-    if (_expire == UINT64_MAX)
-        _expire = _ms_since_first_tick + _retransmission_timeout;  // start timer
-    _next_seqno += seg.length_in_sequence_space();                 // update sender seqno
+    if (not _rtt_probe.has_value()) {  // time this segment
+        _rtt_probe.emplace(_next_seqno + seg.length_in_sequence_space(), _ms_since_first_tick);
+    }
+    if (pacing_rate() > 0) {
+        _pacing_tokens -= seg.payload().size();
+    }
+    if (_ecn && seg.payload().size() > 0) {  // (only this first transmission is ECN-capable)
+        seg.header().cwr = _cwr_pending;
+        seg.ecn() = IPv4Header::ECN_ECT0;
+        _cwr_pending = false;
+    }
+    // start track: the payload is shared with the segment sent, not copied
+    const size_t packet_size = seg.gso_size() > 0 ? seg.gso_size() : seg.payload().size();
+    track(_next_seqno, seg.payload(), seg.header().syn, seg.header().fin, packet_size);
+    _segments_out.push(seg);  // push to sender buffer
+    if (!_timers.pending(RETRANSMISSION_TIMER)) {  // start timer
+        _timers.schedule(RETRANSMISSION_TIMER, _ms_since_first_tick + _retransmission_timeout);
+    }
+    _next_seqno += seg.length_in_sequence_space();  // update sender seqno
+    if (_rack_tlp) {
+        schedule_loss_probe();
+    }
 }
 
-bool TCPSender::fully_acknowledged(const TCPSegment &segment, const WrappingInt32 ackno) {
-    uint64_t end64 = unwrap(segment.header().seqno, _isn, _next_seqno) + segment.length_in_sequence_space();
-    uint64_t ack64 = unwrap(ackno, _isn, _next_seqno);
-    return ack64 >= end64;
+//! \details An entry per packet, as the network sees them, so that SACK and loss detection keep their precision
+//! with segmentation offload.
+uint64_t TCPSender::track(uint64_t start, Buffer payload, const bool syn, const bool fin, const size_t packet_size) {
+    auto hint = _outstanding.lower_bound(start);
+    bool first = true;
+    do {
+        Buffer piece = payload;
+        piece.remove_suffix(payload.size() - min(payload.size(), packet_size));
+        payload.remove_prefix(piece.size());
+        OutstandingSegment outstanding{
+            piece, syn && first, fin && payload.size() == 0, _ms_since_first_tick, false, {}, false};
+        if (_rack_tlp) {
+            outstanding.order = _send_order.insert(_send_order.end(), start);
+        }
+        hint = next(_outstanding.emplace_hint(hint, start, outstanding));
+        start += outstanding.length_in_sequence_space();
+        first = false;
+    } while (payload.size() > 0);
+    return start;
+}
+
+//! \details The segment is built afresh, so it carries none of the original's ECN marks (RFC 3168 section 6.1.5).
+void TCPSender::retransmit(const uint64_t start, OutstandingSegment &outstanding) {
+    TCPSegment seg;
+    seg.header().seqno = wrap(start, _isn);
+    seg.header().syn = outstanding.syn;
+    seg.header().fin = outstanding.fin;
+    seg.payload() = outstanding.payload;
+    _segments_out.push(move(seg));
+    _rtt_probe.reset();
+    outstanding.sent = _ms_since_first_tick;
+    outstanding.retransmitted = true;
+    rack_unmark_lost(start, outstanding);
+    if (outstanding.order.has_value()) {  // it is now the last one sent
+        _send_order.splice(_send_order.end(), _send_order, outstanding.order.value());
+    }
+}
+
+//! \returns the configuration of a sender built from just a capacity, timeout and ISN: TCPConfig's defaults
+//! for everything else
+static TCPConfig sender_config(const size_t capacity,
+                               const uint16_t retx_timeout,
+                               const std::optional<WrappingInt32> fixed_isn) {
+    TCPConfig cfg;
+    cfg.send_capacity = capacity;
+    cfg.rt_timeout = retx_timeout;
+    cfg.fixed_isn = fixed_isn;
+    return cfg;
 }
 
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
 TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
-    : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
-    , _initial_retransmission_timeout{retx_timeout}
-    , _retransmission_timeout(retx_timeout)
-    , _stream(capacity)
-    , _unacknowledged_segments() {}
+    : TCPSender(sender_config(capacity, retx_timeout, fixed_isn)) {}
+
+//! \param[in] cfg the send capacity, retransmission timeout settings, ISN, outbound stream mode, MSS,
+//! congestion control algorithm, and Nagle, persist timer and RACK-TLP settings to use
+//! \details With TCPConfig::mtu_probing, segments start out no larger than MAX_PAYLOAD_SIZE.
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : _isn(cfg.fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , _initial_retransmission_timeout{cfg.rt_timeout}
+    , _retransmission_timeout(cfg.rt_timeout)
+    , _stream(cfg.send_capacity, cfg.zero_copy_send)
+    , _mss(cfg.mtu_probing ? min(cfg.mss, TCPConfig::MAX_PAYLOAD_SIZE) : cfg.mss)
+    , _segmentation_offload(cfg.segmentation_offload)
+    , _mtu_probing(cfg.mtu_probing)
+    , _probe_high(cfg.mss)
+    , _congestion_control(cfg.congestion_control)
+    , _congestion(CongestionController::create(_congestion_control, _mss))
+    , _pacing(cfg.pacing)
+    , _configured_pacing_rate(cfg.pacing_rate)
+    , _pacing_tokens(static_cast<double>(PACING_BURST_SEGMENTS * _mss))
+    , _persist(cfg.persist_timer)
+    , _rack_tlp(cfg.rack_tlp)
+    , _nagle(cfg.nagle)
+    , _adaptive_rto(cfg.adaptive_rto)
+    , _min_rto(cfg.rt_timeout_min)
+    , _max_rto(cfg.rt_timeout_max) {}
+
+void TCPSender::rtt_sample(const size_t rtt_ms) {
+    const double rtt = static_cast<double>(rtt_ms);
+    if (not _srtt.has_value()) {
+        _srtt = rtt;
+        _rttvar = rtt / 2;
+    } else {
+        _rttvar = 0.75 * _rttvar + 0.25 * abs(_srtt.value() - rtt);
+        _srtt = 0.875 * _srtt.value() + 0.125 * rtt;
+    }
+}
+
+//! Before the first RTT sample, or without TCPConfig::adaptive_rto, this is the configured timeout.
+//! Otherwise it is SRTT + max(G, 4 * RTTVAR), with a clock granularity G of one millisecond.
+size_t TCPSender::base_retransmission_timeout() const {
+    if (not _adaptive_rto or not _srtt.has_value()) {
+        return _initial_retransmission_timeout;
+    }
+    const auto rto = static_cast<size_t>(ceil(_srtt.value() + max(1.0, 4 * _rttvar)));
+    return clamp(rto, _min_rto, _max_rto);
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - _last_ackno; }
 
@@ -57,23 +162,59 @@ void TCPSender::fill_window() {
         return;
     }
 
+    if (_persist && _window_size == 0) {  // nothing goes out but probes, once everything sent is acknowledged
+        if (bytes_in_flight() == 0 && (!_stream.buffer_empty() || _stream.eof()) && !_timers.pending(PERSIST_TIMER)) {
+            _persist_backoff = _retransmission_timeout;
+            _timers.schedule(PERSIST_TIMER, _ms_since_first_tick + _persist_backoff);
+        }
+        return;
+    }
+
     uint64_t window_size = _window_size == 0 ? 1 : _window_size;
+    window_size = min<uint64_t>(window_size, _congestion->window());
 
     if (window_size > bytes_in_flight()) {
         uint64_t fill_size;
         do {
+            if (!refill_pacing_tokens()) {  // wait for tick()
+                _pacing_blocked = true;
+                break;
+            }
+
+            // Nagle and corking: wait for more data to fill out a partial segment, unless the stream has ended
+            const size_t mss = max_payload_size();
+            if (!_stream.input_ended() && _stream.buffer_size() < mss &&
+                (_corked || (_nagle && bytes_in_flight() > 0))) {
+                break;
+            }
+
             fill_size = window_size - bytes_in_flight();
 
             seg = TCPSegment();
 
+            size_t payload_size = mss;
+            bool offload = false;
+            const size_t probe_size = (_mss + _probe_high + 1) / 2;  // binary search between the two
+            if (mtu_probe_due() && _stream.buffer_size() >= probe_size && fill_size >= probe_size) {
+                payload_size = probe_size;
+                _mtu_probe.emplace(_next_seqno, probe_size);
+            } else if (_segmentation_offload && pacing_rate() == 0) {  // (pacing goes a packet at a time)
+                payload_size = max(mss, TCPConfig::MAX_OFFLOAD_SIZE / mss * mss);
+                offload = true;
+            }
+
             if (!_stream.buffer_empty()) {  // read as more as possible
-                seg.payload() = _stream.read(std::min(static_cast<size_t>(fill_size), TCPConfig::MAX_PAYLOAD_SIZE));
+                seg.payload() = _stream.read_buffer(std::min(static_cast<size_t>(fill_size), payload_size));
             }
 
             if (_stream.eof() && seg.length_in_sequence_space() < fill_size) {  // mark fin
                 seg.header().fin = true;
             }
 
+            if (offload) {  // the adapter splits it into packets
+                seg.gso_size() = mss;
+            }
+
             if (seg.length_in_sequence_space() > 0) {  // do not send empty packet
                 send_segment(seg);
             }
@@ -82,11 +223,57 @@ void TCPSender::fill_window() {
     }
 }
 
+//! \details The congestion controller's rate comes first; otherwise, with TCPConfig::pacing, the configured
+//! rate, or PACING_GAIN times the window per smoothed RTT (no pacing until there is an RTT sample).
+size_t TCPSender::pacing_rate() const {
+    const size_t controller_rate = _congestion->pacing_rate();
+    if (controller_rate > 0 || !_pacing) {
+        return controller_rate;
+    }
+    if (_configured_pacing_rate > 0) {
+        return _configured_pacing_rate;
+    }
+    if (!_srtt.has_value()) {
+        return 0;
+    }
+    const double window = static_cast<double>(min<size_t>(_window_size, _congestion->window()));
+    return static_cast<size_t>(PACING_GAIN * window * 1000 / max(1.0, _srtt.value()));
+}
+
+size_t TCPSender::pacing_quantum() const { return clamp<size_t>(_stream.buffer_size(), 1, _mss); }
+
+//! \details The bucket holds a few segments, or a millisecond's worth at the pacing rate if that is more,
+//! since time only advances in whole milliseconds.
+bool TCPSender::refill_pacing_tokens() {
+    const size_t rate = pacing_rate();
+    if (rate == 0) {
+        return true;
+    }
+    const double depth = max(static_cast<double>(PACING_BURST_SEGMENTS * _mss), rate / 1000.0);
+    const double earned = rate * static_cast<double>(_ms_since_first_tick - _pacing_refill_time) / 1000;
+    _pacing_tokens = min(depth, _pacing_tokens + earned);
+    _pacing_refill_time = _ms_since_first_tick;
+    return _pacing_tokens >= pacing_quantum();
+}
+
+optional<size_t> TCPSender::pacing_delay() const {
+    const size_t rate = pacing_rate();
+    if (!_pacing_blocked || rate == 0) {
+        return {};
+    }
+    const double missing = pacing_quantum() - _pacing_tokens;
+    return max<size_t>(1, static_cast<size_t>(ceil(missing * 1000 / rate)));
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+void TCPSender::ack_received(const WrappingInt32 ackno, const uint32_t window_size, const bool pure_ack) {
     TCPSegment segment;
     uint64_t ack64 = unwrap(ackno, _isn, _next_seqno);
+    const optional<uint32_t> echo_reply = _timestamp_echo;
+    _timestamp_echo.reset();
+    const bool ecn_echo = _ecn_echo;
+    _ecn_echo = false;
 
     if (_next_seqno == 0) {  // CLOSED
         return;
@@ -100,6 +287,7 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
             return;
         }
         if (ack64 == _last_ackno && window_size <= _window_size) {  // ignore old ack packet
+            same_ack_received(ack64, window_size, pure_ack, ecn_echo);
             return;
         }
         if (ack64 > _next_seqno) {  // ignore exceed ack packet
@@ -111,6 +299,7 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
             return;
         }
         if (ack64 == _last_ackno && window_size <= _window_size) {  // ignore old ack packet
+            same_ack_received(ack64, window_size, pure_ack, ecn_echo);
             return;
         }
         if (ack64 > _next_seqno) {  // ignore exceed ack packet
@@ -121,22 +310,98 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
         return;
     }
 
+    bool partial_ack = false;
+    if (_fast_recovery && ack64 > _last_ackno) {
+        if (ack64 < _recover && _congestion->on_partial_ack(ack64 - _last_ackno)) {  // NewReno: stay in recovery
+            partial_ack = true;
+        } else {  // the acknowledgment that ends recovery is new data acknowledged all the same
+            _congestion->on_recovery_end();
+            _congestion->on_ack(ack64 - _last_ackno, _ms_since_first_tick);
+            _fast_recovery = false;
+        }
+    } else if (_last_ackno != 0 && ack64 > _last_ackno) {  // the SYN's acknowledgment doesn't open the window
+        _congestion->on_ack(ack64 - _last_ackno, _ms_since_first_tick);
+    }
+    if (ack64 > _last_ackno) {
+        _duplicate_acks = 0;
+    }
+
+    optional<size_t> rtt{};
+    if (echo_reply.has_value()) {  // the echoed timestamp times every new acknowledgment, even of retransmissions
+        if (ack64 > _last_ackno) {
+            rtt = static_cast<uint32_t>(timestamp() - echo_reply.value());
+        }
+    } else if (_rtt_probe.has_value() && ack64 >= _rtt_probe->first) {
+        // Karn's algorithm: the probe is dropped whenever a segment is retransmitted, so this sample is unambiguous
+        rtt = _ms_since_first_tick - _rtt_probe->second;
+    }
+    if (_rtt_probe.has_value() && ack64 >= _rtt_probe->first) {
+        _rtt_probe.reset();
+    }
+
     _last_ackno = ack64;
 
     _window_size = window_size;
 
-    _retransmission_timeout = _initial_retransmission_timeout;  // reset timeout
+    if (ecn_echo) {
+        congestion_mark_echoed(ack64);
+    }
+
+    if (rtt.has_value()) {
+        _min_rtt = min(_min_rtt.value_or(rtt.value()), rtt.value());
+        rtt_sample(rtt.value());
+        _congestion->on_rtt_sample(rtt.value(), _ms_since_first_tick);
+    }
+
+    _retransmission_timeout = base_retransmission_timeout();  // reset timeout
 
     _consecutive_retransmissions = 0;  // reset retransmit counter
 
     // untrack acknowledged segments
-    while (!_unacknowledged_segments.empty() && fully_acknowledged(_unacknowledged_segments[0], ackno)) {
-        _unacknowledged_segments.pop_front();
+    while (!_outstanding.empty()) {
+        const auto &[start, outstanding] = *_outstanding.begin();
+        const uint64_t end = start + outstanding.length_in_sequence_space();
+        if (end > ack64) {
+            break;
+        }
+        if (_rack_tlp) {
+            rack_delivered(outstanding, end);
+            rack_forget(start, _outstanding.begin()->second);
+        }
+        _outstanding.erase(_outstanding.begin());
     }
-    if (_unacknowledged_segments.empty()) {
-        _expire = UINT64_MAX;  // stop timer
-    } else {
-        _expire = _ms_since_first_tick + _retransmission_timeout;  // reset timer
+    while (!_sacked.empty() && _sacked.begin()->first < ack64) {  // forget what is now acknowledged anyway
+        const auto [start, end] = *_sacked.begin();
+        _sacked.erase(_sacked.begin());
+        _sacked_bytes -= end - start;
+        if (end > ack64) {
+            _sacked.emplace(ack64, end);
+            _sacked_bytes += end - ack64;
+        }
+    }
+    if (_mtu_probe.has_value() && ack64 >= _mtu_probe->first + _mtu_probe->second) {  // the probe got through
+        _mss = _mtu_probe->second;
+        _mtu_probe.reset();
+    }
+    if (partial_ack) {
+        retransmit_next_hole();
+    }
+    if (_rack_tlp) {
+        if (_loss_probe_end.has_value() && ack64 >= _loss_probe_end.value()) {  // the probe episode is over
+            _loss_probe_end.reset();
+        }
+        rack_detect_loss();
+    }
+    if (_window_size > 0) {  // the window opened up, so stop probing it
+        _timers.cancel(PERSIST_TIMER);
+    }
+    if (_outstanding.empty()) {
+        _timers.cancel(RETRANSMISSION_TIMER);  // stop timer
+    } else if (!_timers.pending(PERSIST_TIMER)) {  // (an outstanding window probe is up to the persist timer)
+        _timers.schedule(RETRANSMISSION_TIMER, _ms_since_first_tick + _retransmission_timeout);  // reset timer
+    }
+    if (_rack_tlp) {
+        schedule_loss_probe();
     }
 
     // if (window_size > 0) { // fill the window again if new space has opened up
@@ -148,18 +413,379 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 void TCPSender::tick(const size_t ms_since_last_tick) {
     _ms_since_first_tick += ms_since_last_tick;
 
-    if (_expire > _ms_since_first_tick) {  // not expired
+    if (_pacing_blocked) {
+        _pacing_blocked = false;
+        fill_window();
+    }
+
+    bool expired = false;
+    for (const auto timer : _timers.advance(_ms_since_first_tick)) {
+        if (timer == PERSIST_TIMER) {
+            send_window_probe();
+        } else if (timer == LOSS_PROBE_TIMER) {
+            send_loss_probe();
+        } else if (timer == REORDER_TIMER) {
+            rack_detect_loss();
+        } else {
+            expired = true;
+        }
+    }
+    if (!expired) {
         return;
     }
 
-    if (!_unacknowledged_segments.empty()) {
-        _segments_out.push(_unacknowledged_segments[0]);  // retransmit earliest lost packet
-        if (_window_size != 0) {
-            _retransmission_timeout *= 2;    // double the timeout
+    if (mtu_probe_lost()) {
+        return;
+    }
+
+    if (!_outstanding.empty()) {
+        retransmit(_outstanding.begin()->first, _outstanding.begin()->second);  // retransmit earliest lost packet
+        _loss_probe_end.reset();
+        if (_window_size != 0 || _persist) {
+            if (_consecutive_retransmissions == 0) {  // only the first timeout in a row is a new congestion signal
+                _congestion->on_timeout(bytes_in_flight(), _ms_since_first_tick);
+            }
+            _fast_recovery = false;
+            _duplicate_acks = 0;
+            _recover = _next_seqno;
+            _retransmission_timeout *= 2;  // double the timeout
+            if (_adaptive_rto) {
+                _retransmission_timeout = min(_retransmission_timeout, _max_rto);
+            }
             _consecutive_retransmissions++;  // increment retransmit counter
         }
-        _expire = _ms_since_first_tick + _retransmission_timeout;  // reset timer
+        _timers.schedule(RETRANSMISSION_TIMER, _ms_since_first_tick + _retransmission_timeout);  // reset timer
+    }
+}
+
+//! \details It acknowledges nothing new, but may still be a duplicate acknowledgment, shrink the window, echo a
+//! congestion mark, or SACK something new.
+void TCPSender::same_ack_received(const uint64_t ack64,
+                                  const uint32_t window_size,
+                                  const bool pure_ack,
+                                  const bool ecn_echo) {
+    if (pure_ack && window_size == _window_size) {
+        duplicate_ack_received();
+    } else if (_persist) {  // but not a window update that shrinks the window
+        _window_size = window_size;
+    }
+    if (ecn_echo) {  // a congestion mark counts on any acknowledgment
+        congestion_mark_echoed(ack64);
+    }
+    if (_rack_tlp) {  // it may still SACK something new
+        rack_detect_loss();
+    }
+}
+
+//! \details Back off once per window of data, unless fast recovery already has.
+void TCPSender::congestion_mark_echoed(const uint64_t ackno) {
+    if (_ecn && !_fast_recovery && ackno > _ecn_recover) {
+        _congestion->on_congestion_mark(bytes_in_flight(), _ms_since_first_tick);
+        _ecn_recover = _next_seqno;
+        _cwr_pending = true;
+    }
+}
+
+void TCPSender::duplicate_ack_received() {
+    if (_outstanding.empty() || (_persist && _window_size == 0)) {  // answers to probes aren't duplicates
+        return;
+    }
+
+    _duplicate_acks++;
+    if (_fast_recovery) {  // each further duplicate means another segment has left the network
+        _congestion->on_dup_ack();
+        if (!_sacked.empty()) {  // and SACK may say which one to send again
+            retransmit_next_hole();
+        }
+    } else if (_duplicate_acks == DUPLICATE_ACK_THRESHOLD && mtu_probe_lost()) {
+        _duplicate_acks = 0;
+    } else if (_duplicate_acks == DUPLICATE_ACK_THRESHOLD && _last_ackno > _recover) {  // fast retransmit
+        _congestion->on_loss(bytes_in_flight(), _ms_since_first_tick);
+        _fast_recovery = true;
+        _recover = _next_seqno;
+        _retransmit_next = _last_ackno;
+        retransmit_next_hole();
+    }
+}
+
+//! \details The probe carries the next byte of the stream (or its FIN), as RFC 9293 section 3.8.6.1 asks. It
+//! isn't a retransmission: probing goes on for as long as the receiver keeps answering with a zero window, backed
+//! off up to the largest retransmission timeout.
+void TCPSender::send_window_probe() {
+    if (_window_size != 0) {
+        return;
+    }
+    if (!_outstanding.empty()) {
+        retransmit(_outstanding.begin()->first, _outstanding.begin()->second);
+    } else {
+        TCPSegment probe;
+        if (!_stream.buffer_empty()) {
+            probe.payload() = _stream.read_buffer(1);
+        } else if (_stream.eof()) {
+            probe.header().fin = true;
+        }
+        send_segment(probe);
+        _timers.cancel(RETRANSMISSION_TIMER);
+    }
+    _persist_backoff = min(2 * _persist_backoff, _max_rto);
+    _timers.schedule(PERSIST_TIMER, _ms_since_first_tick + _persist_backoff);
+}
+
+void TCPSender::set_max_segment_size(const size_t mss) {
+    _mss = max<size_t>(min(_mss, mss), 1);
+    _probe_high = max(min(_probe_high, mss), _mss);
+    _congestion = CongestionController::create(_congestion_control, _mss);
+}
+
+//! Probing waits while loss recovery is going on, or while segments carry options that the probe size doesn't
+//! allow for, and stops once the search range is narrow enough.
+bool TCPSender::mtu_probe_due() const {
+    return _mtu_probing && !_mtu_probe.has_value() && !_fast_recovery && _consecutive_retransmissions == 0 &&
+           _option_overhead == 0 && _probe_high >= _mss + MTU_PROBE_STEP;
+}
+
+//! Losing a probe says nothing about congestion (RFC 4821 section 7.5): the search range shrinks,
+//! and the probe's data goes out again right away in segments of the current MSS, with no backoff.
+bool TCPSender::mtu_probe_lost() {
+    if (!_mtu_probe.has_value() || _outstanding.empty() || _outstanding.begin()->first != _mtu_probe->first) {
+        return false;
+    }
+    const uint64_t start = _mtu_probe->first;
+    _probe_high = _mtu_probe->second - 1;
+    _mtu_probe.reset();
+
+    const Buffer payload = _outstanding.begin()->second.payload;
+    const bool fin = _outstanding.begin()->second.fin;
+    rack_forget(start, _outstanding.begin()->second);
+    _outstanding.erase(_outstanding.begin());
+
+    const uint64_t end = track(start, payload, false, fin, _mss);
+    for (auto it = _outstanding.begin(); it != _outstanding.end() && it->first < end; ++it) {
+        retransmit(it->first, it->second);
+    }
+    _timers.schedule(RETRANSMISSION_TIMER, _ms_since_first_tick + _retransmission_timeout);
+    return true;
+}
+
+uint64_t TCPSender::sacked_through(const uint64_t seqno) const {
+    auto it = _sacked.upper_bound(seqno);
+    if (it == _sacked.begin()) {
+        return seqno;
+    }
+    --it;
+    return max(seqno, it->second);
+}
+
+//! Without SACK information, only the first unacknowledged segment is known to be missing.
+//! With it, so is every segment below the highest SACKed seqno that no block covers.
+//! \details The search skips each SACKed range in one lookup, so it costs O(log n) per range rather than a walk
+//! over every outstanding segment.
+void TCPSender::retransmit_next_hole() {
+    auto it = _outstanding.lower_bound(_retransmit_next);
+    while (it != _outstanding.end()) {
+        const uint64_t start = it->first;
+        const uint64_t end = start + it->second.length_in_sequence_space();
+        const uint64_t sacked_end = sacked_through(start);
+        if (sacked_end >= end) {  // go on from the first segment that ends past the SACKed range
+            it = _outstanding.upper_bound(sacked_end);
+            if (prev(it)->first + prev(it)->second.length_in_sequence_space() > sacked_end) {
+                --it;
+            }
+            continue;
+        }
+        const bool missing = _sacked.empty() ? start <= _last_ackno : start < _sacked.rbegin()->second;
+        if (missing) {
+            retransmit(start, it->second);
+            _retransmit_next = end;
+        }
+        return;
+    }
+}
+
+//! \param blocks the SACK blocks of the incoming segment. Blocks at or below the ackno
+//! (including D-SACK blocks) and blocks beyond anything sent are ignored.
+void TCPSender::sack_received(const vector<pair<WrappingInt32, WrappingInt32>> &blocks) {
+    for (const auto &[left, right] : blocks) {
+        uint64_t start = unwrap(left, _isn, _next_seqno);
+        uint64_t end = unwrap(right, _isn, _next_seqno);
+        if (start <= _last_ackno || end > _next_seqno || start >= end) {
+            continue;
+        }
+
+        // merge with the ranges it overlaps or touches
+        auto it = _sacked.lower_bound(start);
+        if (it != _sacked.begin() && prev(it)->second >= start) {
+            --it;
+            start = it->first;
+        }
+        while (it != _sacked.end() && it->first <= end) {
+            end = max(end, it->second);
+            _sacked_bytes -= it->second - it->first;
+            it = _sacked.erase(it);
+        }
+        _sacked.emplace(start, end);
+        _sacked_bytes += end - start;
+        if (_rack_tlp) {
+            _new_sacks.emplace_back(unwrap(left, _isn, _next_seqno), unwrap(right, _isn, _next_seqno));
+        }
+    }
+}
+
+//! \details A retransmission is ignored if it was delivered sooner than a round trip could take: it is the
+//! original transmission that got through.
+void TCPSender::rack_delivered(const OutstandingSegment &outstanding, const uint64_t end) {
+    const size_t sent = outstanding.sent;
+    const size_t rtt = _ms_since_first_tick - sent;
+    if (outstanding.retransmitted && _min_rtt.has_value() && rtt < _min_rtt.value()) {
+        return;
+    }
+    if (!_rack_segment.has_value() || sent > _rack_segment->first ||
+        (sent == _rack_segment->first && end > _rack_segment->second)) {
+        _rack_segment.emplace(sent, end);
+        _rack_rtt = rtt;
+    }
+}
+
+void TCPSender::rack_forget(const uint64_t start, OutstandingSegment &outstanding) {
+    if (outstanding.order.has_value()) {
+        _send_order.erase(outstanding.order.value());
+        outstanding.order.reset();
+    }
+    rack_unmark_lost(start, outstanding);
+}
+
+void TCPSender::rack_unmark_lost(const uint64_t start, OutstandingSegment &outstanding) {
+    if (outstanding.lost) {
+        outstanding.lost = false;
+        _lost.erase(start);
+        _lost_bytes -= outstanding.length_in_sequence_space();
+    }
+}
+
+//! \details Like RFC 6675's pipe, what is in the network is taken to be what is in flight, less what the
+//! receiver has SACKed and what is known lost. A lost segment goes out again while that leaves room in the window,
+//! and otherwise waits for an acknowledgment to make room, so that a whole flight found lost at once isn't sent
+//! again in one burst just after the window was cut.
+void TCPSender::retransmit_lost() {
+    while (!_lost.empty()) {
+        const uint64_t start = *_lost.begin();
+        OutstandingSegment &outstanding = _outstanding.at(start);
+        const uint64_t length = outstanding.length_in_sequence_space();
+        const uint64_t pipe = bytes_in_flight() - min<uint64_t>(bytes_in_flight(), _sacked_bytes + _lost_bytes);
+        if (pipe > 0 && pipe + length > _congestion->window()) {
+            return;
+        }
+        retransmit(start, outstanding);
+        _retransmit_next = max(_retransmit_next, start + length);
+    }
+}
+
+//! \details A segment is lost once it was sent before _rack_segment and has gone unacknowledged for as long as
+//! _rack_segment took to be delivered, plus a reordering window of a quarter of the minimum RTT (RFC 8985
+//! section 6.2). The first loss starts fast recovery, as a third duplicate acknowledgment would.
+//!
+//! Only the segments in ranges SACKed since the last call are looked at for delivery, and the scan for loss
+//! walks _send_order up to _rack_segment, so neither costs a walk over everything in flight.
+void TCPSender::rack_detect_loss() {
+    for (const auto &[left, right] : _new_sacks) {  // segments newly SACKed, starting with the one holding `left`
+        auto it = _outstanding.upper_bound(left);
+        if (it != _outstanding.begin()) {
+            --it;
+        }
+        for (; it != _outstanding.end() && it->first < right; ++it) {
+            OutstandingSegment &outstanding = it->second;
+            const uint64_t start = it->first;
+            if (outstanding.order.has_value() && outstanding.payload.size() > 0 &&  // (not a FIN)
+                sacked(start, start + outstanding.payload.size())) {
+                rack_delivered(outstanding, start + outstanding.length_in_sequence_space());
+                rack_forget(start, outstanding);
+            }
+        }
+    }
+    _new_sacks.clear();
+    if (!_rack_segment.has_value()) {
+        return;
+    }
+
+    const size_t reordering_window = _min_rtt.value_or(0) / 4;
+    size_t wait = 0;
+    bool found_lost = false;
+    for (const uint64_t start : _send_order) {
+        OutstandingSegment &outstanding = _outstanding.at(start);
+        const size_t sent = outstanding.sent;
+        if (sent > _rack_segment->first) {
+            break;  // this one and all after it were sent after the segment that was delivered
+        }
+        if (outstanding.lost ||
+            (sent == _rack_segment->first && start + outstanding.length_in_sequence_space() >= _rack_segment->second)) {
+            continue;
+        }
+        const size_t deadline = sent + _rack_rtt + reordering_window;
+        if (deadline > _ms_since_first_tick) {  // it may only be reordered, so far
+            wait = max(wait, deadline - _ms_since_first_tick);
+            continue;
+        }
+        outstanding.lost = true;
+        _lost.insert(start);
+        _lost_bytes += outstanding.length_in_sequence_space();
+        found_lost = true;
+    }
+
+    if (found_lost && !_fast_recovery && _last_ackno > _recover) {
+        _congestion->on_loss(bytes_in_flight(), _ms_since_first_tick);
+        _fast_recovery = true;
+        _recover = _next_seqno;
+        _retransmit_next = _last_ackno;
+    }
+    retransmit_lost();
+
+    if (wait > 0) {
+        _timers.schedule(REORDER_TIMER, _ms_since_first_tick + wait);
+    } else {
+        _timers.cancel(REORDER_TIMER);
+    }
+}
+
+//! \details The probe timeout is two smoothed RTTs, plus the longest a delayed ACK takes when only one segment
+//! is outstanding (RFC 8985 section 7.2). There is no probe during fast recovery, into a zero window, or
+//! while an earlier probe is unacknowledged.
+void TCPSender::schedule_loss_probe() {
+    if (_outstanding.empty() || _fast_recovery || _window_size == 0 || _loss_probe_end.has_value()) {
+        _timers.cancel(LOSS_PROBE_TIMER);
+        return;
+    }
+    size_t timeout = _srtt.has_value() ? static_cast<size_t>(ceil(2 * _srtt.value())) : _retransmission_timeout;
+    if (_outstanding.size() == 1) {
+        timeout += TCPConfig::ACK_DELAY_DFLT;
+    }
+    const optional<size_t> rto_deadline = _timers.deadline(RETRANSMISSION_TIMER);
+    if (rto_deadline.has_value() && _ms_since_first_tick + timeout >= rto_deadline.value()) {
+        _timers.cancel(LOSS_PROBE_TIMER);  // the retransmission timer will do
+        return;
+    }
+    _timers.schedule(LOSS_PROBE_TIMER, _ms_since_first_tick + timeout);
+}
+
+//! \details New data makes a better probe, since it isn't a retransmission if nothing was lost; either way the
+//! receiver's acknowledgment (and its SACK blocks) gives RACK what it needs to find the loss.
+void TCPSender::send_loss_probe() {
+    if (_outstanding.empty() || _fast_recovery) {
+        return;
+    }
+    _loss_probe_end = _next_seqno;
+    const uint64_t room = _window_size > bytes_in_flight() ? _window_size - bytes_in_flight() : 0;
+    if (!_stream.buffer_empty() && room > 0) {
+        TCPSegment seg;
+        seg.payload() = _stream.read_buffer(min<size_t>(room, max_payload_size()));
+        if (_stream.eof() && seg.length_in_sequence_space() < room) {
+            seg.header().fin = true;
+        }
+        send_segment(seg);
+        _loss_probe_end = _next_seqno;
+    } else {
+        retransmit(_outstanding.rbegin()->first, _outstanding.rbegin()->second);
     }
+    _timers.schedule(RETRANSMISSION_TIMER, _ms_since_first_tick + _retransmission_timeout);
 }
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _consecutive_retransmissions; }
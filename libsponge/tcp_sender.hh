@@ -2,13 +2,22 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
+#include "timer_wheel.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <functional>
+#include <list>
 #include <map>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <set>
+#include <utility>
+#include <vector>
 
 //! \brief The "sender" part of a TCP implementation.
 
@@ -32,7 +41,11 @@ class TCPSender {
 
     size_t _retransmission_timeout;
 
-    size_t _expire{UINT64_MAX};
+    //! timers of the sender, on the clock of _ms_since_first_tick
+    TimerWheel _timers{};
+
+    //! the retransmission timer, pending while any segment is unacknowledged
+    static constexpr TimerWheel::TimerId RETRANSMISSION_TIMER = 0;
 
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
@@ -42,15 +55,259 @@ class TCPSender {
 
     uint64_t _last_ackno{0};
 
-    uint16_t _window_size{1};
+    //! the receiver's window, already scaled up if window scaling is in use
+    uint32_t _window_size{1};
 
     uint16_t _consecutive_retransmissions{0};
 
-    std::deque<TCPSegment> _unacknowledged_segments;
+    //! a segment sent but not yet fully acknowledged: just what it takes to build it again, with its payload
+    //! shared with the copy that was sent rather than copied
+    struct OutstandingSegment {
+        Buffer payload;
+        bool syn;
+        bool fin;
+        size_t sent;         //!< when it was last sent
+        bool retransmitted;  //!< was that a retransmission?
+        //! its place in _send_order, while RACK may still find it lost
+        std::optional<std::list<uint64_t>::iterator> order;
+        bool lost;  //!< RACK found it lost, and it hasn't been sent again since
 
-    void send_segment(TCPSegment seg);
+        size_t length_in_sequence_space() const { return payload.size() + (syn ? 1 : 0) + (fin ? 1 : 0); }
+    };
+
+    //! the retransmission buffer: outstanding segments by their first seqno (absolute), so that an
+    //! acknowledgment trims it from the front and SACK blocks and holes are found by lookup
+    std::map<uint64_t, OutstandingSegment> _outstanding{};
+
+    //! most payload bytes in one segment
+    size_t _mss;
+
+    //! option bytes that new segments carry beyond those _mss leaves room for (see set_option_overhead())
+    size_t _option_overhead{0};
+
+    //! \returns the most payload bytes in a new segment: _mss, less the _option_overhead
+    size_t max_payload_size() const { return _mss - std::min(_option_overhead, _mss - 1); }
+
+    //! send segments of up to TCPConfig::MAX_OFFLOAD_SIZE bytes, for the adapter to split into packets of _mss
+    //! (TCPConfig::segmentation_offload)?
+    bool _segmentation_offload{false};
+
+    //! search for a larger _mss with probe segments (TCPConfig::mtu_probing)?
+    bool _mtu_probing{false};
+
+    //! largest payload size that might still fit the path: probes stay at or below it
+    size_t _probe_high;
+
+    //! search resolution: probing stops once _probe_high is less than this far above _mss
+    static constexpr size_t MTU_PROBE_STEP = 32;
+
+    //! the outstanding probe segment, if any: its first seqno (absolute) and its payload size
+    std::optional<std::pair<uint64_t, size_t>> _mtu_probe{};
+
+    //! is it time to send a probe segment?
+    bool mtu_probe_due() const;
+
+    //! \brief React to the loss of the probe segment, if it is the first unacknowledged segment
+    //! \returns whether it was
+    bool mtu_probe_lost();
+
+    //! congestion control algorithm, kept to start over when the MSS is set
+    TCPConfig::CongestionControl _congestion_control;
+
+    //! congestion window, consulted alongside the receiver's window
+    std::unique_ptr<CongestionController> _congestion;
+
+    //! the segment being timed for a round-trip sample: its end (absolute seqno) and when it was sent
+    std::optional<std::pair<uint64_t, size_t>> _rtt_probe{};
+
+    //! pace segments even when the congestion controller doesn't ask for it (TCPConfig::pacing)?
+    bool _pacing{false};
+
+    //! TCPConfig::pacing_rate: bytes per second, or 0 to follow the window and the smoothed RTT
+    size_t _configured_pacing_rate{0};
+
+    //! how much faster than a window per smoothed RTT to pace, so pacing spreads segments out
+    //! without holding back a window that is still growing
+    static constexpr double PACING_GAIN = 1.2;
+
+    //! the token bucket holds at least this many full-sized segments, so pacing allows a small burst
+    static constexpr size_t PACING_BURST_SEGMENTS = 2;
+
+    //! token bucket: bytes of payload that may leave now without exceeding the pacing rate
+    double _pacing_tokens{0};
+
+    //! when tokens were last added to the bucket
+    size_t _pacing_refill_time{0};
+
+    //! did fill_window() stop early because of pacing?
+    bool _pacing_blocked{false};
+
+    //! \returns the pacing rate, in bytes per second, or 0 for no pacing
+    size_t pacing_rate() const;
+
+    //! \returns the payload bytes the next segment will carry, as far as pacing is concerned
+    size_t pacing_quantum() const;
+
+    //! \brief Add the tokens earned since the last refill
+    //! \returns whether the bucket holds enough for the next segment (always, without pacing)
+    bool refill_pacing_tokens();
+
+    //! duplicate acknowledgments that trigger a fast retransmit
+    static constexpr unsigned int DUPLICATE_ACK_THRESHOLD = 3;
+
+    //! duplicate acknowledgments received since the ackno last advanced
+    unsigned int _duplicate_acks{0};
+
+    //! are we in fast recovery?
+    bool _fast_recovery{false};
+
+    //! _next_seqno when loss was last detected: recovery ends once it is acknowledged,
+    //! and no new fast retransmit starts before then
+    uint64_t _recover{0};
+
+    //! count a duplicate acknowledgment, and fast retransmit on the third
+    void duplicate_ack_received();
+
+    //! an acknowledgment of `ack64` (absolute), which is no more than was acknowledged already, with a window no
+    //! larger than before
+    void same_ack_received(const uint64_t ack64, const uint32_t window_size, const bool pure_ack, const bool ecn_echo);
+
+    //! SACK scoreboard: merged [start, end) ranges of absolute seqnos the receiver reported holding
+    std::map<uint64_t, uint64_t> _sacked{};
+
+    //! how many seqnos the scoreboard covers
+    uint64_t _sacked_bytes{0};
+
+    //! during fast recovery, segments that start below this have already been retransmitted
+    uint64_t _retransmit_next{0};
+
+    //! \returns the end of the scoreboard range covering `seqno`, or `seqno` itself if none does
+    uint64_t sacked_through(const uint64_t seqno) const;
+
+    //! is all of [start, end) covered by the scoreboard?
+    bool sacked(const uint64_t start, const uint64_t end) const { return sacked_through(start) >= end; }
+
+    //! retransmit the first segment at or after _retransmit_next that is known to be missing
+    void retransmit_next_hole();
+
+    //! probe a zero window on the persist timer (TCPConfig::persist_timer), rather than treat it as one byte?
+    bool _persist{false};
+
+    //! the persist timer, pending while a zero window holds back data that is waiting to be sent
+    static constexpr TimerWheel::TimerId PERSIST_TIMER = 1;
+
+    //! interval of the persist timer, doubled after every probe
+    size_t _persist_backoff{0};
+
+    //! send a one-byte probe into a zero window, or the unanswered probe again
+    void send_window_probe();
+
+    //! detect loss by send time, and probe for a lost tail (TCPConfig::rack_tlp)?
+    bool _rack_tlp{false};
+
+    //! RACK: of the segments delivered so far (acknowledged or SACKed), the one sent last:
+    //! when it was sent, and its end (absolute seqno)
+    std::optional<std::pair<size_t, uint64_t>> _rack_segment{};
+
+    //! RACK: the round-trip time of _rack_segment
+    size_t _rack_rtt{0};
+
+    //! RACK: first seqnos (absolute) of the outstanding segments not yet SACKed, in the order they were last sent
+    //! (a retransmission moves its segment to the back), so that the loss scan stops at _rack_segment
+    std::list<uint64_t> _send_order{};
+
+    //! RACK: [start, end) ranges (absolute seqnos) that SACK blocks have reported since the last loss scan
+    std::vector<std::pair<uint64_t, uint64_t>> _new_sacks{};
 
-    inline bool fully_acknowledged(const TCPSegment &segment, const WrappingInt32 ackno);
+    //! RACK: first seqnos (absolute) of the segments found lost and not yet sent again, and their total length
+    std::set<uint64_t> _lost{};
+    uint64_t _lost_bytes{0};
+
+    //! the smallest round-trip time sample, which sets how much reordering RACK allows for
+    std::optional<size_t> _min_rtt{};
+
+    //! the reordering timer, pending while a segment sent before _rack_segment may yet turn out to be lost
+    static constexpr TimerWheel::TimerId REORDER_TIMER = 2;
+
+    //! the loss probe timer, pending while a lost tail would otherwise have to wait for the retransmission timer
+    static constexpr TimerWheel::TimerId LOSS_PROBE_TIMER = 3;
+
+    //! _next_seqno after the loss probe went out, until it is acknowledged: one probe per episode
+    std::optional<uint64_t> _loss_probe_end{};
+
+    //! \brief Add what was sent from `start` (absolute seqno) to the retransmission buffer
+    //! \param packet_size the most payload bytes per entry (only 0 if there is no payload)
+    //! \returns the seqno (absolute) just past it
+    uint64_t track(uint64_t start, Buffer payload, const bool syn, const bool fin, const size_t packet_size);
+
+    //! build the outstanding segment that starts at `start` (absolute seqno) and send it again, and remember when
+    void retransmit(const uint64_t start, OutstandingSegment &outstanding);
+
+    //! RACK: the outstanding segment that ends at `end` (absolute seqno) was delivered
+    void rack_delivered(const OutstandingSegment &outstanding, const uint64_t end);
+
+    //! RACK: stop considering the outstanding segment that starts at `start` (absolute seqno) for loss
+    void rack_forget(const uint64_t start, OutstandingSegment &outstanding);
+
+    //! RACK: `outstanding`, which starts at `start` (absolute seqno), is no longer waiting to be sent again
+    void rack_unmark_lost(const uint64_t start, OutstandingSegment &outstanding);
+
+    //! RACK: send segments found lost again, as far as the congestion window allows
+    void retransmit_lost();
+
+    //! RACK: take note of the SACKed segments, then retransmit those sent long enough before _rack_segment
+    void rack_detect_loss();
+
+    //! (re)arm the loss probe timer, if a probe is due before the retransmission timer
+    void schedule_loss_probe();
+
+    //! send new data, or else the last segment again, so that the receiver acknowledges a lost tail
+    void send_loss_probe();
+
+    //! send new data ECN-capable, and react to ECN-Echo? (see set_ecn())
+    bool _ecn{false};
+
+    //! the acknowledgment about to be received carries ECN-Echo
+    bool _ecn_echo{false};
+
+    //! _next_seqno when the window was last reduced for ECN-Echo: no further reduction until it is acknowledged
+    uint64_t _ecn_recover{0};
+
+    //! set CWR on the next segment of new data, to tell the receiver that the window was reduced
+    bool _cwr_pending{false};
+
+    //! an acknowledgment of `ackno` (absolute) carried ECN-Echo
+    void congestion_mark_echoed(const uint64_t ackno);
+
+    //! hold back a partial segment while earlier data is unacknowledged (TCPConfig::nagle)?
+    bool _nagle{false};
+
+    //! hold back partial segments until uncorked?
+    bool _corked{false};
+
+    //! compute the retransmission timeout from RTT samples (TCPConfig::adaptive_rto)?
+    bool _adaptive_rto{false};
+
+    //! bounds of the computed retransmission timeout, in milliseconds
+    size_t _min_rto{TCPConfig::MIN_TIMEOUT_DFLT};
+    size_t _max_rto{TCPConfig::MAX_TIMEOUT_DFLT};
+
+    //! smoothed round-trip time, once there has been a sample
+    std::optional<double> _srtt{};
+
+    //! round-trip time variation
+    double _rttvar{0};
+
+    //! the echo reply (TSecr) of the timestamps option on the acknowledgment about to be received
+    std::optional<uint32_t> _timestamp_echo{};
+
+    //! fold a round-trip time sample into _srtt and _rttvar ([RFC 6298](\ref rfc::rfc6298) section 2)
+    void rtt_sample(const size_t rtt_ms);
+
+    //! \returns the retransmission timeout before any backoff
+    size_t base_retransmission_timeout() const;
+
+    void send_segment(TCPSegment seg);
 
   public:
     //! Initialize a TCPSender
@@ -58,6 +315,9 @@ class TCPSender {
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from a full configuration
+    explicit TCPSender(const TCPConfig &cfg);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -68,7 +328,37 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param pure_ack `false` if the acknowledgment came on a segment that occupies sequence space,
+    //! which can't be counted as a duplicate acknowledgment
+    //! \param window_size the receiver's window, in bytes (after applying any window scale)
+    void ack_received(const WrappingInt32 ackno, const uint32_t window_size, const bool pure_ack = true);
+
+    //! \brief SACK blocks were received; they are taken into account by the next ack_received()
+    void sack_received(const std::vector<std::pair<WrappingInt32, WrappingInt32>> &blocks);
+
+    //! \brief The next acknowledgment carries a timestamps option that echoes `echo_reply`, an earlier timestamp()
+    //! \details With timestamps, every acknowledgment of new data gives a round-trip time sample (RFC 7323 section 4)
+    void timestamp_echo_received(const uint32_t echo_reply) { _timestamp_echo = echo_reply; }
+
+    //! \brief The next acknowledgment carries ECN-Echo: a segment of ours reached the receiver marked CE
+    void ecn_echo_received() { _ecn_echo = true; }
+
+    //! \brief Send new data ECN-capable (ECT(0)) and back off from ECN-Echo (RFC 3168 section 6.1)
+    //! \details Call once both ends have agreed to use ECN. Retransmissions are never ECN-capable.
+    void set_ecn(const bool ecn) { _ecn = ecn; }
+
+    //! \brief Limit segments to at most `mss` bytes of payload (from the peer's MSS option)
+    //! \note Starts congestion control over with the new MSS, so call it before any data is sent
+    void set_max_segment_size(const size_t mss);
+
+    //! \brief New segments will carry `bytes` of options that max_segment_size() leaves no room for (such as
+    //! SACK blocks), so they carry that much less payload (RFC 6691)
+    void set_option_overhead(const size_t bytes) { _option_overhead = bytes; }
+
+    //! \brief Hold back segments smaller than the MSS, so that later writes can fill them out
+    //! \details A corked sender still sends full segments, and the rest of the stream once it ends.
+    //! Call fill_window() after uncorking to send what was held back.
+    void set_corked(const bool corked) { _corked = corked; }
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -91,6 +381,33 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief The smoothed round-trip time in milliseconds, if any RTT has been measured
+    std::optional<double> smoothed_rtt() const { return _srtt; }
+
+    //! \brief The round-trip time variation, in milliseconds
+    double rtt_variation() const { return _rttvar; }
+
+    //! \brief The current retransmission timeout in milliseconds, including any backoff
+    size_t retransmission_timeout() const { return _retransmission_timeout; }
+
+    //! \brief The most payload bytes the sender puts in a segment
+    size_t max_segment_size() const { return _mss; }
+
+    //! \brief The most payload bytes the sender might put in a probe segment (at least max_segment_size())
+    size_t max_probe_size() const { return _probe_high; }
+
+    //! \brief How long, in milliseconds, until pacing lets the next segment go, if it is holding one back
+    std::optional<size_t> pacing_delay() const;
+
+    //! \brief Is the sender holding back partial segments? (see set_corked())
+    bool corked() const { return _corked; }
+
+    //! \brief The sender's clock, in milliseconds modulo 2^32, for the timestamps option of outgoing segments
+    uint32_t timestamp() const { return static_cast<uint32_t>(_ms_since_first_tick); }
+
+    //! \brief The congestion window, in bytes (SIZE_MAX if the sender has no congestion control)
+    size_t congestion_window() const { return _congestion->window(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
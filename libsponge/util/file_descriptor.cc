@@ -73,6 +73,27 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in] buffers is the storage to read into, filled in order; fewer bytes than fit may be read
+//! \note used with [readv(2)](\ref man2::readv) to read straight into a ByteStream
+size_t FileDescriptor::read(const vector<iovec> &buffers) {
+    size_t limit = 0;
+    for (const auto &buf : buffers) {
+        limit += buf.iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), buffers.data(), buffers.size()));
+    if (limit > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(limit)) {
+        throw runtime_error("readv() read more than requested");
+    }
+
+    register_read();
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
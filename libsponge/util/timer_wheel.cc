@@ -0,0 +1,137 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+bool TimerWheel::live(const Entry &entry) const {
+    const auto it = _timers.find(entry.id);
+    return it != _timers.end() && it->second.second == entry.generation;
+}
+
+//! \details An entry goes in the lowest level whose range, counting from the current time, covers its
+//! deadline: that is, the lowest level above which the deadline and the current time agree.
+void TimerWheel::insert(const Entry &entry) {
+    const size_t deadline = max(entry.deadline, _now);
+    for (size_t level = 0; level < LEVELS; level++) {
+        if ((deadline >> (SLOT_BITS * (level + 1))) == (_now >> (SLOT_BITS * (level + 1)))) {
+            const size_t slot = (deadline >> (SLOT_BITS * level)) & (SLOTS - 1);
+            _slots[level][slot].push_back(entry);
+            _occupied[level] |= uint64_t{1} << slot;
+            return;
+        }
+    }
+    _overflow.push_back(entry);
+}
+
+void TimerWheel::cascade(const size_t level) {
+    const size_t slot = (_now >> (SLOT_BITS * level)) & (SLOTS - 1);
+    vector<Entry> entries;
+    entries.swap(_slots[level][slot]);
+    _occupied[level] &= ~(uint64_t{1} << slot);
+    for (const auto &entry : entries) {
+        if (live(entry)) {
+            insert(entry);
+        }
+    }
+}
+
+void TimerWheel::expire_slot(vector<TimerId> &fired) {
+    const size_t slot = _now & (SLOTS - 1);
+    if ((_occupied[0] & (uint64_t{1} << slot)) == 0) {
+        return;
+    }
+    vector<Entry> entries;
+    entries.swap(_slots[0][slot]);
+    _occupied[0] &= ~(uint64_t{1} << slot);
+    for (const auto &entry : entries) {
+        if (live(entry)) {
+            fired.push_back(entry.id);
+            _timers.erase(entry.id);
+        }
+    }
+}
+
+void TimerWheel::schedule(const TimerId id, const size_t deadline) {
+    const uint64_t generation = _next_generation++;
+    _timers[id] = {deadline, generation};
+    insert({id, deadline, generation});
+}
+
+optional<size_t> TimerWheel::deadline(const TimerId id) const {
+    const auto it = _timers.find(id);
+    if (it == _timers.end()) {
+        return {};
+    }
+    return it->second.first;
+}
+
+//! \details Each level's next occupied slot is reached at a time with all the lower levels' bits zero; the
+//! overflow list is looked at again once the top level has gone all the way round.
+size_t TimerWheel::next_event() const {
+    size_t next = SIZE_MAX;
+    for (size_t level = 0; level < LEVELS; level++) {
+        const size_t shift = SLOT_BITS * level;
+        const size_t slot = (_now >> shift) & (SLOTS - 1);
+        const uint64_t later = slot + 1 < SLOTS ? _occupied[level] & (~uint64_t{0} << (slot + 1)) : 0;
+        if (later != 0) {
+            const size_t rotation = (_now >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            next = min(next, rotation + (static_cast<size_t>(__builtin_ctzll(later)) << shift));
+        }
+    }
+    if (!_overflow.empty()) {
+        next = min(next, ((_now >> (SLOT_BITS * LEVELS)) + 1) << (SLOT_BITS * LEVELS));
+    }
+    return next;
+}
+
+//! \details The clock jumps from one occupied slot to the next (see next_event()), bringing timers down
+//! from the levels above whenever it lands on the start of their span, and firing those due at level 0.
+vector<TimerWheel::TimerId> TimerWheel::advance(const size_t now) {
+    vector<TimerId> fired;
+    expire_slot(fired);  // timers scheduled for a time that had already come
+
+    while (_now < now) {
+        if (_timers.empty()) {  // nothing to fire: drop the leftover entries and jump
+            for (size_t level = 0; level < LEVELS; level++) {
+                for (size_t slot = 0; _occupied[level] != 0; slot++) {
+                    if (_occupied[level] & (uint64_t{1} << slot)) {
+                        _slots[level][slot].clear();
+                        _occupied[level] &= ~(uint64_t{1} << slot);
+                    }
+                }
+            }
+            _overflow.clear();
+            _now = now;
+            break;
+        }
+
+        const size_t next = next_event();
+        if (next > now) {
+            _now = now;
+            break;
+        }
+        _now = next;
+
+        if ((_now & (SLOTS - 1)) == 0) {
+            if ((_now & ((size_t{1} << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+                vector<Entry> entries;
+                entries.swap(_overflow);
+                for (const auto &entry : entries) {
+                    if (live(entry)) {
+                        insert(entry);
+                    }
+                }
+            }
+            for (size_t level = LEVELS - 1; level > 0; level--) {  // from the top, so entries can fall through
+                if ((_now & ((size_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+                    cascade(level);
+                }
+            }
+        }
+        expire_slot(fired);
+    }
+
+    return fired;
+}
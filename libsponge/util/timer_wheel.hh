@@ -0,0 +1,89 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: timers named by an id, each due at an absolute time in milliseconds
+//! \details Level 0 has a slot for each of the next 64 milliseconds, level 1 a slot for each of the next 64
+//! 64-millisecond spans, and so on; timers further out than the top level wait in an overflow list. A timer
+//! moves down a level each time the clock reaches its slot, and the clock skips empty slots, so advance()
+//! costs only as much as the timers it touches, however many are pending and however far it goes.
+//!
+//! Rescheduling or cancelling a timer leaves its old entry behind to be dropped when the clock reaches it.
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;  //!< Names a timer; each id has at most one pending deadline
+
+  private:
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr size_t LEVELS = 4;
+
+    struct Entry {
+        TimerId id;
+        size_t deadline;
+        uint64_t generation;  //!< tells a live entry from one left behind by a reschedule or cancel
+    };
+
+    //! the wheel's clock, in milliseconds
+    size_t _now{0};
+
+    //! pending timers: deadline and the generation of their live entry
+    std::unordered_map<TimerId, std::pair<size_t, uint64_t>> _timers{};
+
+    uint64_t _next_generation{0};
+
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> _slots{};
+
+    //! for each level, a bit per non-empty slot
+    std::array<uint64_t, LEVELS> _occupied{};
+
+    //! entries due beyond the reach of the top level
+    std::vector<Entry> _overflow{};
+
+    //! is `entry` the current one for its timer?
+    bool live(const Entry &entry) const;
+
+    //! put an entry in the slot for its deadline
+    void insert(const Entry &entry);
+
+    //! move the entries of a slot (of a level above 0) down to the levels below
+    void cascade(const size_t level);
+
+    //! \returns the next time after now at which a slot of some level comes up, or SIZE_MAX if none will
+    size_t next_event() const;
+
+    //! fire the live entries of the level-0 slot for the current time
+    void expire_slot(std::vector<TimerId> &fired);
+
+  public:
+    //! \brief (Re)arm timer `id` to fire at `deadline` (at once, on the next advance(), if that has passed)
+    void schedule(const TimerId id, const size_t deadline);
+
+    //! \brief Disarm timer `id`, if it is pending
+    void cancel(const TimerId id) { _timers.erase(id); }
+
+    //! \brief Is timer `id` pending?
+    bool pending(const TimerId id) const { return _timers.count(id) > 0; }
+
+    //! \brief When timer `id` is due, if it is pending
+    std::optional<size_t> deadline(const TimerId id) const;
+
+    //! \brief The number of pending timers
+    size_t size() const { return _timers.size(); }
+
+    //! \brief The wheel's clock, in milliseconds
+    size_t now() const { return _now; }
+
+    //! \brief Move the clock forward to `now` milliseconds
+    //! \returns the ids of the timers that came due, in order of their deadlines; they are no longer pending
+    std::vector<TimerId> advance(const size_t now);
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
@@ -0,0 +1,58 @@
+#include "byte_stream.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStream stream{10, true};
+            const Buffer written{string("hello, world")};
+
+            test_should_be(stream.write(written), size_t(10));
+            test_should_be(stream.buffer_size(), size_t(10));
+            test_should_be(stream.remaining_capacity(), size_t(0));
+
+            // a read from within one written Buffer shares its storage
+            const Buffer hello = stream.read_buffer(5);
+            test_should_be(hello.str() == "hello", true);
+            test_should_be(hello.str().data() == written.str().data(), true);
+            test_should_be(stream.bytes_read(), size_t(5));
+
+            test_should_be(stream.write(string("!?")), size_t(2));
+            test_should_be(stream.peek_output(7) == ", wor!?", true);
+
+            // a read across two written Buffers yields one slice per Buffer
+            const BufferList rest = stream.read_buffers(7);
+            test_should_be(rest.buffers().size(), size_t(2));
+            test_should_be(rest.buffers().front().str().data() == written.str().data() + 5, true);
+            test_should_be(rest.concatenate() == ", wor!?", true);
+            test_should_be(stream.buffer_empty(), true);
+
+            stream.end_input();
+            test_should_be(stream.eof(), true);
+            test_should_be(stream.bytes_written(), size_t(12));
+        }
+
+        {
+            ByteStream stream{4};
+            const Buffer written{string("abcdef")};
+
+            // the ring copies, but must accept the same bytes
+            test_should_be(stream.write(written), size_t(4));
+            test_should_be(stream.read_buffer(3).str() == "abc", true);
+            test_should_be(stream.write(string("xyz")), size_t(3));
+            test_should_be(stream.read(4) == "dxyz", true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
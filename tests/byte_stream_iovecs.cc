@@ -0,0 +1,59 @@
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+int main() {
+    try {
+        for (const bool chunked : {false, true}) {
+            auto [read_end, write_end] = make_pipe();
+            ByteStream stream{8, chunked};
+
+            // wrap the ring's write position around its end
+            test_should_be(stream.write(string("abcdef")), size_t(6));
+            stream.pop_output(6);
+
+            write_end.write("0123456789");
+            test_should_be(stream.write_from_fd(read_end), size_t(8));
+            test_should_be(stream.peek_output(8) == "01234567", true);
+
+            size_t total = 0;
+            for (const auto &iov : stream.peek_iovecs(5)) {
+                total += iov.iov_len;
+            }
+            test_should_be(total, size_t(5));
+            test_should_be(stream.peek_iovecs(5).size(), size_t(chunked ? 1 : 2));
+
+            test_should_be(stream.read_into_fd(write_end, 5), size_t(5));
+            test_should_be(stream.bytes_read(), size_t(11));
+            test_should_be(stream.write_from_fd(read_end), size_t(5));
+            test_should_be(stream.read(8) == "56789012", true);
+
+            test_should_be(stream.read_into_fd(write_end, 5), size_t(0));
+            write_end.close();
+            test_should_be(stream.write_from_fd(read_end), size_t(2));
+            test_should_be(stream.write_from_fd(read_end), size_t(0));
+            test_should_be(read_end.eof(), true);
+            test_should_be(stream.read(8) == "34", true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
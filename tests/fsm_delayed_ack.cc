@@ -0,0 +1,134 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.delayed_ack = true;
+        const string full(TCPConfig::MAX_PAYLOAD_SIZE, 'x');
+
+        // test 1: every second full-sized segment is acknowledged
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            for (unsigned int i = 0; i < 3; i++) {
+                test_1.send_data(rx_isn + 1 + 2 * i * full.size(), tx_isn + 1, full.begin(), full.end());
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: first full-sized segment acknowledged at once");
+                test_1.send_data(rx_isn + 1 + (2 * i + 1) * full.size(), tx_isn + 1, full.begin(), full.end());
+                test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + (2 * i + 2) * full.size()),
+                               "test 1 failed: second full-sized segment not acknowledged");
+            }
+        }
+
+        // test 2: a small segment is acknowledged when the timer runs out, unless data carries the ACK first
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string small = "hello";
+            test_2.send_data(rx_isn + 1, tx_isn + 1, small.begin(), small.end());
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: small segment acknowledged at once");
+            test_2.execute(Tick(cfg.ack_delay - 1u));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: delayed ACK sent early");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6).with_payload_size(0),
+                           "test 2 failed: delayed ACK not sent");
+
+            test_2.send_data(rx_isn + 6, tx_isn + 1, small.begin(), small.end());
+            test_2.execute(Write{"world"});
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 11).with_data("world"),
+                           "test 2 failed: data did not carry the ACK");
+            test_2.execute(Tick(cfg.ack_delay));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ACK sent twice");
+        }
+
+        // test 3: out-of-order segments, and the one that fills the hole, are acknowledged at once
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_3.send_data(rx_isn + 1 + full.size(), tx_isn + 1, full.begin(), full.end());
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1),
+                           "test 3 failed: out-of-order segment not acknowledged at once");
+            test_3.send_data(rx_isn + 1, tx_isn + 1, full.begin(), full.end());
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + 2 * full.size()),
+                           "test 3 failed: segment filling the hole not acknowledged at once");
+            test_3.execute(ExpectData{}.with_data(full + full));
+        }
+
+        // test 4: a segment merged from two full-sized ones (receive offload) is acknowledged at once
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string merged = full + full;
+            test_4.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 1)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_data(string(merged))
+                               .with_merged(2, full.size()));
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + merged.size()),
+                           "test 4 failed: merged segment not acknowledged at once");
+        }
+
+        // test 5: so is one merged from a full-sized segment and a smaller one
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string merged = full + full.substr(0, full.size() / 2);
+            test_5.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 1)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_data(string(merged))
+                               .with_merged(2, full.size()));
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + merged.size()),
+                           "test 5 failed: merged segment not acknowledged at once");
+        }
+
+        // test 6: with an MSS larger than the peer's, the peer's largest segments are the full-sized ones
+        {
+            TCPConfig large_mss = cfg;
+            large_mss.mss = 1460;
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_6 = TCPTestHarness::in_established(large_mss, tx_isn, rx_isn);
+
+            for (unsigned int i = 0; i < 2; i++) {
+                test_6.send_data(rx_isn + 1 + 2 * i * full.size(), tx_isn + 1, full.begin(), full.end());
+                test_6.execute(ExpectNoSegment{}, "test 6 failed: first full-sized segment acknowledged at once");
+                test_6.send_data(rx_isn + 1 + (2 * i + 1) * full.size(), tx_isn + 1, full.begin(), full.end());
+                test_6.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + (2 * i + 2) * full.size()),
+                               "test 6 failed: second full-sized segment not acknowledged");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#include "ipv4_header.hh"
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.ecn = true;
+        const string data = "hello";
+
+        // test 1: an active open negotiates ECN, then congestion marks are echoed until the peer sends CWR
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_1(cfg);
+
+            test_1.execute(Connect{});
+            const TCPSegment syn = test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false),
+                                                     "test 1 failed: no SYN");
+            if (not syn.header().ece or not syn.header().cwr) {
+                throw runtime_error("test 1 failed: SYN didn't offer ECN");
+            }
+            const WrappingInt32 tx_isn = syn.header().seqno;
+
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_ece(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            TCPSegment ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1),
+                                               "test 1 failed: no ACK of the SYN/ACK");
+            if (ack.header().ece or ack.header().cwr) {
+                throw runtime_error("test 1 failed: ACK of the SYN/ACK had ECN flags");
+            }
+
+            auto data_seg = [&](const size_t i) {
+                return SendSegment{}
+                    .with_ack(true)
+                    .with_ackno(tx_isn + 1)
+                    .with_seqno(rx_isn + 1 + i * data.size())
+                    .with_win(1000)
+                    .with_data(string(data));
+            };
+
+            test_1.execute(data_seg(0).with_ecn(IPv4Header::ECN_ECT0));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + data.size()),
+                                    "test 1 failed: no ACK of unmarked data");
+            if (ack.header().ece) {
+                throw runtime_error("test 1 failed: ECE without a congestion mark");
+            }
+
+            test_1.execute(data_seg(1).with_ecn(IPv4Header::ECN_CE));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true), "test 1 failed: no ACK of marked data");
+            if (not ack.header().ece) {
+                throw runtime_error("test 1 failed: congestion mark not echoed");
+            }
+
+            test_1.execute(data_seg(2).with_ecn(IPv4Header::ECN_ECT0));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true), "test 1 failed: no ACK of later data");
+            if (not ack.header().ece) {
+                throw runtime_error("test 1 failed: ECE stopped before CWR");
+            }
+
+            test_1.execute(data_seg(3).with_ecn(IPv4Header::ECN_ECT0).with_cwr(true));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true), "test 1 failed: no ACK of data with CWR");
+            if (ack.header().ece) {
+                throw runtime_error("test 1 failed: ECE continued after CWR");
+            }
+            test_1.execute(ExpectData{}.with_data(data + data + data + data));
+        }
+
+        // test 2: a listener accepts an ECN-setup SYN with an ECN-setup SYN/ACK
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_listen(cfg);
+
+            test_2.execute(SendSegment{}.with_syn(true).with_ece(true).with_cwr(true).with_seqno(rx_isn).with_win(1000));
+            const TCPSegment syn_ack = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 2 failed: no SYN/ACK");
+            if (not syn_ack.header().ece or syn_ack.header().cwr) {
+                throw runtime_error("test 2 failed: SYN/ACK didn't accept ECN");
+            }
+        }
+
+        // test 3: without an ECN-setup SYN, the connection doesn't use ECN
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_listen(cfg);
+
+            test_3.send_syn(rx_isn);
+            const TCPSegment syn_ack = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 3 failed: no SYN/ACK");
+            if (syn_ack.header().ece or syn_ack.header().cwr) {
+                throw runtime_error("test 3 failed: SYN/ACK offered ECN unasked");
+            }
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_3.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_ackno(tx_isn + 1)
+                               .with_seqno(rx_isn + 1)
+                               .with_win(1000)
+                               .with_data(string(data))
+                               .with_ecn(IPv4Header::ECN_CE));
+            const TCPSegment ack =
+                test_3.expect_seg(ExpectOneSegment{}.with_ack(true), "test 3 failed: no ACK of marked data");
+            if (ack.header().ece) {
+                throw runtime_error("test 3 failed: congestion mark echoed without ECN");
+            }
+        }
+
+        // test 4: a TCP that doesn't use ECN doesn't accept an ECN-setup SYN
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_listen(TCPConfig{});
+
+            test_4.execute(SendSegment{}.with_syn(true).with_ece(true).with_cwr(true).with_seqno(rx_isn).with_win(1000));
+            const TCPSegment syn_ack = test_4.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 4 failed: no SYN/ACK");
+            if (syn_ack.header().ece or syn_ack.header().cwr) {
+                throw runtime_error("test 4 failed: SYN/ACK accepted ECN");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
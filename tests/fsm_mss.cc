@@ -0,0 +1,112 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! \returns bytes of options in `seg`
+size_t options_length(const TCPSegment &seg) { return 4 * seg.header().doff - TCPHeader::LENGTH; }
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+        cfg.sack = true;
+
+        const WrappingInt32 rx_isn(rd());
+        WrappingInt32 tx_isn{0};
+
+        // an active open to a peer that sends the given MSS option
+        const auto connect = [&](const uint16_t peer_mss) {
+            TCPTestHarness test(cfg);
+            test.execute(Connect{});
+            const TCPSegment syn = test.expect_seg(ExpectOneSegment{}.with_syn(true), "no SYN");
+            tx_isn = syn.header().seqno;
+            test.execute(SendSegment{}
+                             .with_syn(true)
+                             .with_ack(true)
+                             .with_seqno(rx_isn)
+                             .with_ackno(tx_isn + 1)
+                             .with_win(4000)
+                             .with_mss(peer_mss)
+                             .with_sack_permitted(true)
+                             .with_timestamps(1, syn.header().timestamps->first));
+            test.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1), "no ACK of the SYN/ACK");
+            return test;
+        };
+
+        // out-of-order data from the peer, which leaves a hole before it
+        const auto out_of_order = [&](const uint32_t offset) {
+            return SendSegment{}
+                .with_ack(true)
+                .with_seqno(rx_isn + 1 + offset)
+                .with_ackno(tx_isn + 1)
+                .with_win(4000)
+                .with_data(string(10, 'x'));
+        };
+
+        // tests 1 and 2: an MSS option too small for the timestamps (or for anything) is raised to a minimum
+        for (const uint16_t peer_mss : {0, 8}) {
+            TCPTestHarness test = connect(peer_mss);
+            test.execute(Write{string(100, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(64 - 12));
+            test.execute(ExpectSegment{}.with_payload_size(100 - (64 - 12)));
+            test.execute(ExpectNoSegment{});
+        }
+
+        // test 3: new data leaves room for the SACK blocks it carries
+        {
+            TCPTestHarness test = connect(1000);
+            test.execute(out_of_order(100));
+            TCPSegment seg = test.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1),
+                                             "test 3 failed: out-of-order data not acknowledged");
+            test_err_if(seg.header().sack_blocks.size() != 1, "test 3 failed: no SACK block");
+
+            test.execute(Write{string(2000, 'a')});
+            for (const size_t payload_size : {976, 976, 48}) {  // 1000, less timestamps and one SACK block
+                seg = test.expect_seg(ExpectSegment{}.with_payload_size(payload_size), "test 3 failed: no data");
+                test_err_if(seg.header().sack_blocks.size() != 1, "test 3 failed: data without the SACK block");
+                test_err_if(seg.payload().size() + options_length(seg) > 1000, "test 3 failed: segment over MSS");
+            }
+        }
+
+        // test 4: a full-sized segment sent before the hole appeared goes out again without SACK blocks
+        {
+            TCPTestHarness test = connect(1000);
+            test.execute(Write{string(988, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(988));
+            test.execute(out_of_order(100));
+            test.execute(out_of_order(200));
+            test.expect_seg(ExpectSegment{}.with_ack(true), "test 4 failed: out-of-order data not acknowledged");
+            test.expect_seg(ExpectSegment{}.with_ack(true), "test 4 failed: out-of-order data not acknowledged");
+
+            test.execute(Tick(cfg.rt_timeout));
+            const TCPSegment seg = test.expect_seg(ExpectOneSegment{}.with_payload_size(988),
+                                                   "test 4 failed: no retransmission");
+            test_err_if(not seg.header().sack_blocks.empty(), "test 4 failed: SACK blocks on a full segment");
+            test_err_if(seg.payload().size() + options_length(seg) > 1000, "test 4 failed: segment over MSS");
+
+            // but a pure acknowledgment still carries them
+            test.execute(out_of_order(300));
+            const TCPSegment ack = test.expect_seg(ExpectOneSegment{}.with_ack(true).with_payload_size(0),
+                                                   "test 4 failed: out-of-order data not acknowledged");
+            test_err_if(ack.header().sack_blocks.size() != 3, "test 4 failed: ACK without its SACK blocks");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
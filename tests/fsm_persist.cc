@@ -0,0 +1,100 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.persist_timer = true;
+
+        // test 1: a zero window is probed with one byte, backing off without ever giving up
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_1.send_ack(rx_isn + 1, tx_isn + 1, 0);
+            test_1.execute(Write{"hello"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: data sent into a zero window");
+
+            for (unsigned int i = 0; i < 2 * TCPConfig::MAX_RETX_ATTEMPTS; i++) {
+                const size_t interval = min<size_t>(size_t{cfg.rt_timeout} << i, cfg.rt_timeout_max);
+                test_1.execute(Tick(interval - 1));
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: probe sent early");
+                test_1.execute(Tick(1));
+                test_1.execute(ExpectOneSegment{}.with_payload_size(1).with_data("h").with_seqno(tx_isn + 1),
+                               "test 1 failed: no probe");
+                test_1.send_ack(rx_isn + 1, tx_isn + 1, 0);
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: refused probe answered");
+            }
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            // the window opens: the rest follows the probe
+            test_1.send_ack(rx_isn + 1, tx_isn + 1, 1000);
+            test_1.execute(ExpectOneSegment{}.with_data("ello").with_seqno(tx_isn + 2),
+                           "test 1 failed: data not sent once the window opened");
+            test_1.execute(Tick(cfg.rt_timeout));
+            test_1.execute(ExpectOneSegment{}.with_data("h").with_seqno(tx_isn + 1),
+                           "test 1 failed: unacknowledged probe not retransmitted");
+        }
+
+        // test 2: a probe that gets in is acknowledged, and the next one carries the next byte
+        {
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_2.send_ack(rx_isn + 1, tx_isn + 1, 0);
+            test_2.execute(Write{"ab"});
+            test_2.execute(Tick(cfg.rt_timeout));
+            test_2.execute(ExpectOneSegment{}.with_data("a").with_seqno(tx_isn + 1), "test 2 failed: no probe");
+            test_2.send_ack(rx_isn + 1, tx_isn + 2, 0);
+            test_2.execute(Tick(2 * cfg.rt_timeout - 1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: probe sent early");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_data("b").with_seqno(tx_isn + 2), "test 2 failed: no probe");
+        }
+
+        // test 3: a receive window that fills up is announced again once it reopens
+        {
+            TCPConfig small = cfg;
+            small.recv_capacity = 4000;
+            const WrappingInt32 rx_isn(rd());
+            const WrappingInt32 tx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(small, tx_isn, rx_isn);
+
+            const string data(small.recv_capacity, 'x');
+            test_3.send_data(rx_isn + 1, tx_isn + 1, data.begin(), data.end());
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4001).with_win(0),
+                           "test 3 failed: full window not advertised");
+            test_3.execute(Tick(1));
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: window update while the window is still shut");
+
+            test_3.execute(ExpectData{}.with_data(data));
+            test_3.execute(Tick(1));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4001).with_win(4000),
+                           "test 3 failed: no window update");
+            test_3.execute(Tick(1));
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: window update sent twice");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
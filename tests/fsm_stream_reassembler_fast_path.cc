@@ -0,0 +1,53 @@
+#include "stream_reassembler.hh"
+#include "test_should_be.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            StreamReassembler reassembler{8};
+            const Buffer abc{string("abc")};
+
+            reassembler.push_substring(abc, 0, false);
+            reassembler.push_substring(string("def"), 3, false);
+            test_should_be(reassembler.substrings_pushed(), size_t(2));
+            test_should_be(reassembler.fast_path_pushes(), size_t(2));
+            test_should_be(reassembler.stream_out().read(6) == "abcdef", true);
+
+            // a hole sends everything through reassembly until it is filled
+            reassembler.push_substring(string("jk"), 9, true);
+            reassembler.push_substring(string("gh"), 6, false);
+            test_should_be(reassembler.fast_path_pushes(), size_t(2));
+            reassembler.push_substring(string("i"), 8, false);
+            test_should_be(reassembler.fast_path_pushes(), size_t(2));
+            test_should_be(reassembler.substrings_pushed(), size_t(5));
+            test_should_be(reassembler.stream_out().read(5) == "ghijk", true);
+            test_should_be(reassembler.stream_out().eof(), true);
+        }
+
+        {
+            // the fast path still respects the capacity
+            StreamReassembler reassembler{4};
+            reassembler.push_substring(Buffer{string("abcdef")}, 0, true);
+            test_should_be(reassembler.fast_path_pushes(), size_t(1));
+            test_should_be(reassembler.stream_out().buffer_size(), size_t(4));
+            test_should_be(reassembler.stream_out().input_ended(), false);
+            test_should_be(reassembler.stream_out().read(4) == "abcd", true);
+
+            reassembler.push_substring(Buffer{string("cdef")}, 2, true);
+            test_should_be(reassembler.fast_path_pushes(), size_t(1));
+            test_should_be(reassembler.stream_out().read(2) == "ef", true);
+            test_should_be(reassembler.stream_out().eof(), true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+
+        // test 1: timestamps are echoed, and PAWS drops an old duplicate
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(1000).with_timestamps(100, 0));
+
+            TCPSegment seg =
+                test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1),
+                                  "test 1 failed: SYN/ACK invalid");
+            test_err_if(not seg.header().timestamps.has_value() or seg.header().timestamps->second != 100,
+                        "test 1 failed: SYN/ACK does not echo the SYN's timestamp");
+            const WrappingInt32 ack_base = seg.header().seqno;
+            const uint32_t our_timestamp = seg.header().timestamps->first;
+
+            const auto data_segment = [&](const uint32_t offset, string data, const uint32_t timestamp) {
+                return SendSegment{}
+                    .with_ack(true)
+                    .with_seqno(seq_base + 1 + offset)
+                    .with_ackno(ack_base + 1)
+                    .with_win(1000)
+                    .with_data(move(data))
+                    .with_timestamps(timestamp, our_timestamp);
+            };
+
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_timestamps(200, our_timestamp));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            test_1.execute(data_segment(0, "abcd", 300));
+            seg = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 5),
+                                    "test 1 failed: data not acknowledged");
+            test_err_if(seg.header().timestamps->second != 300, "test 1 failed: ACK does not echo the timestamp");
+            test_1.execute(ExpectData{}.with_data("abcd"));
+
+            // an older timestamp means an old duplicate, even though the seqno looks right
+            test_1.execute(data_segment(4, "efgh", 250));
+            seg = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 5),
+                                    "test 1 failed: old duplicate not acknowledged");
+            test_err_if(seg.header().timestamps->second != 300, "test 1 failed: old duplicate's timestamp was echoed");
+            test_1.execute(ExpectNoData{});
+
+            test_1.execute(data_segment(4, "efgh", 400));
+            seg = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 9),
+                                    "test 1 failed: new data not acknowledged");
+            test_err_if(seg.header().timestamps->second != 400, "test 1 failed: ACK does not echo the timestamp");
+            test_1.execute(ExpectData{}.with_data("efgh"));
+        }
+
+        // test 2: every acknowledgment gives an RTT sample, even for retransmitted data
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Connect{});
+            TCPSegment seg = test_2.expect_seg(ExpectOneSegment{}.with_syn(true), "test 2 failed: no SYN");
+            test_err_if(not seg.header().timestamps.has_value(), "test 2 failed: SYN without timestamps");
+            const WrappingInt32 ack_base = seg.header().seqno;
+
+            test_2.execute(Tick(40));
+            test_2.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(seq_base)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_timestamps(1000, seg.header().timestamps->first));
+            test_2.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 1), "test 2 failed: no ACK");
+            test_err_if(test_2._fsm.smoothed_rtt() != 40, "test 2 failed: RTT not sampled from the SYN/ACK");
+
+            test_2.execute(Write{"hello"});
+            test_2.execute(Tick(1));
+            test_2.expect_seg(ExpectOneSegment{}.with_payload_size(5), "test 2 failed: no data");
+            test_2.execute(Tick(cfg.rt_timeout));
+            seg = test_2.expect_seg(ExpectOneSegment{}.with_payload_size(5), "test 2 failed: no retransmission");
+
+            test_2.execute(Tick(10));
+            test_2.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 6)
+                               .with_win(1000)
+                               .with_timestamps(1100, seg.header().timestamps->first));
+            test_err_if(test_2._fsm.smoothed_rtt() != 0.875 * 40 + 0.125 * 10,
+                        "test 2 failed: RTT not sampled from the retransmission");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.window_scaling = true;
+        cfg.recv_capacity = 1000000;  // needs a shift of 4 to fit in 16 bits
+        cfg.send_capacity = 100000;
+
+        // test 1: both sides scale their windows
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(1000).with_window_scale(3));
+
+            // the window in a SYN is never scaled
+            TCPSegment seg = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(UINT16_MAX),
+                "test 1 failed: SYN/ACK invalid");
+            test_err_if(seg.header().window_scale != 4, "test 1 failed: SYN/ACK without the expected window scale");
+            const WrappingInt32 ack_base = seg.header().seqno;
+
+            test_1.send_ack(seq_base + 1, ack_base + 1, 1000);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            // the peer's window of 1000 means 8000 bytes
+            test_1.execute(Write{string(20000, 'x')});
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectBytesInFlight{8000}, "test 1 failed: peer's window was not scaled");
+
+            // and ours is advertised shifted right by 4
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data(string(16, 'y')));
+            bool acked = false;
+            while (test_1.can_read()) {
+                TCPSegment ack = test_1.expect_seg(ExpectSegment{}.with_ack(true), "test 1 failed: no ACK");
+                if (ack.header().ackno == seq_base + 17) {
+                    test_err_if(ack.header().win != (1000000 - 16) >> 4, "test 1 failed: window was not scaled");
+                    acked = true;
+                }
+            }
+            test_err_if(not acked, "test 1 failed: data was not acknowledged");
+        }
+
+        // test 2: the peer doesn't offer window scaling, so neither side scales
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(1000));
+
+            TCPSegment seg = test_2.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(UINT16_MAX),
+                "test 2 failed: SYN/ACK invalid");
+            test_err_if(seg.header().window_scale.has_value(), "test 2 failed: SYN/ACK has a window scale");
+            const WrappingInt32 ack_base = seg.header().seqno;
+
+            test_2.send_ack(seq_base + 1, ack_base + 1, 1000);
+            test_2.execute(Write{string(20000, 'x')});
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectBytesInFlight{1000}, "test 2 failed: peer's window was scaled");
+
+            while (test_2.can_read()) {
+                TCPSegment data = test_2.expect_seg(ExpectSegment{}.with_ack(true), "test 2 failed: no data");
+                test_err_if(data.header().win != UINT16_MAX, "test 2 failed: window was scaled");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "router.hh"
+#include "tcp_over_ip.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+EthernetAddress private_ethernet_address(const uint8_t last_byte) { return {0x02, 0, 0, 0, 0, last_byte}; }
+
+InternetDatagram make_datagram(const string &src_ip, const string &dst_ip, const uint8_t ecn) {
+    InternetDatagram dgram;
+    dgram.header().src = Address(src_ip, 0).ipv4_numeric();
+    dgram.header().dst = Address(dst_ip, 0).ipv4_numeric();
+    dgram.header().set_ecn(ecn);
+    dgram.payload() = string("hello");
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    return dgram;
+}
+
+EthernetFrame make_frame(const EthernetAddress &src,
+                         const EthernetAddress &dst,
+                         const uint16_t type,
+                         const BufferList payload) {
+    EthernetFrame frame;
+    frame.header().src = src;
+    frame.header().dst = dst;
+    frame.header().type = type;
+    frame.payload() = payload.concatenate();
+    return frame;
+}
+
+//! \returns the ECN codepoint of the next datagram `interface` sends
+uint8_t next_ecn(AsyncNetworkInterface &interface) {
+    if (interface.frames_out().empty()) {
+        throw runtime_error("datagram not forwarded");
+    }
+    InternetDatagram dgram;
+    if (dgram.parse(interface.frames_out().front().payload().concatenate()) != ParseResult::NoError) {
+        throw runtime_error("forwarded datagram unparseable");
+    }
+    interface.frames_out().pop();
+    return dgram.header().ecn();
+}
+
+int main() {
+    try {
+        // the codepoint goes from a segment into its datagram, and back out
+        {
+            TCPOverIPv4Adapter adapter;
+            TCPSegment seg;
+            seg.ecn() = IPv4Header::ECN_ECT0;
+            InternetDatagram dgram = adapter.wrap_tcp_in_ip(seg).front();
+            if (dgram.header().ecn() != IPv4Header::ECN_ECT0 or dgram.header().tos != IPv4Header::ECN_ECT0) {
+                throw runtime_error("ECT(0) lost in wrapping a segment");
+            }
+
+            dgram.header().set_ecn(IPv4Header::ECN_CE);
+            InternetDatagram received;
+            if (received.parse(dgram.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("marked datagram unparseable");
+            }
+            const auto unwrapped = adapter.unwrap_tcp_in_ip(received);
+            if (not unwrapped.has_value() or unwrapped->ecn() != IPv4Header::ECN_CE) {
+                throw runtime_error("CE lost in unwrapping a segment");
+            }
+        }
+
+        // a router marks ECN-capable datagrams, and only those, once its outbound queue builds up
+        {
+            const EthernetAddress host_eth = private_ethernet_address(1);
+            const EthernetAddress router_in_eth = private_ethernet_address(2);
+            const EthernetAddress router_out_eth = private_ethernet_address(3);
+
+            Router router;
+            const size_t in = router.add_interface(NetworkInterface{router_in_eth, Address("10.0.0.1", 0)});
+            const size_t out = router.add_interface(NetworkInterface{router_out_eth, Address("10.0.1.1", 0)});
+            router.add_route(Address("10.0.1.0", 0).ipv4_numeric(), 24, {}, out);
+            router.set_ecn_marking_threshold(2);
+
+            // the outbound interface learns the destination's Ethernet address from its ARP request
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REQUEST;
+            arp.sender_ethernet_address = private_ethernet_address(4);
+            arp.sender_ip_address = Address("10.0.1.2", 0).ipv4_numeric();
+            arp.target_ip_address = Address("10.0.1.1", 0).ipv4_numeric();
+            router.interface(out).recv_frame(
+                make_frame(arp.sender_ethernet_address, ETHERNET_BROADCAST, EthernetHeader::TYPE_ARP, arp.serialize()));
+            while (not router.interface(out).frames_out().empty()) {
+                router.interface(out).frames_out().pop();
+            }
+
+            const uint8_t sent[] = {IPv4Header::ECN_ECT0,
+                                    IPv4Header::ECN_ECT1,
+                                    IPv4Header::ECN_NOT_ECT,
+                                    IPv4Header::ECN_ECT0,
+                                    IPv4Header::ECN_CE};
+            for (const uint8_t ecn : sent) {
+                router.interface(in).recv_frame(make_frame(host_eth,
+                                                           router_in_eth,
+                                                           EthernetHeader::TYPE_IPv4,
+                                                           make_datagram("10.0.0.2", "10.0.1.2", ecn).serialize()));
+            }
+            router.route();
+
+            const uint8_t expected[] = {IPv4Header::ECN_ECT0,
+                                        IPv4Header::ECN_ECT1,
+                                        IPv4Header::ECN_NOT_ECT,
+                                        IPv4Header::ECN_CE,
+                                        IPv4Header::ECN_CE};
+            for (const uint8_t ecn : expected) {
+                const uint8_t forwarded = next_ecn(router.interface(out));
+                if (forwarded != ecn) {
+                    throw runtime_error("forwarded with ECN codepoint " + to_string(forwarded) + " instead of " +
+                                        to_string(ecn));
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "ipv4_header.hh"
+#include "segment_coalescer.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! \returns what `coalescer` passes on after a flush
+vector<TCPSegment> drain(SegmentCoalescer &coalescer) {
+    coalescer.flush();
+    vector<TCPSegment> segments;
+    while (not coalescer.segments_out().empty()) {
+        segments.push_back(coalescer.segments_out().front());
+        coalescer.segments_out().pop();
+    }
+    return segments;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const WrappingInt32 isn(rd());
+        const WrappingInt32 ackno(rd());
+
+        const auto data_seg = [&](const uint32_t offset, const string &payload) {
+            TCPSegment seg;
+            seg.header().seqno = isn + offset;
+            seg.header().ack = true;
+            seg.header().ackno = ackno;
+            seg.header().win = 1000;
+            seg.payload() = string(payload);
+            return seg;
+        };
+
+        // consecutive data merges, up to the FIN
+        {
+            SegmentCoalescer coalescer;
+            coalescer.segment_received(data_seg(0, "abc"));
+            coalescer.segment_received(data_seg(3, "def"));
+            TCPSegment last = data_seg(6, "gh");
+            last.header().fin = true;
+            last.header().psh = true;
+            coalescer.segment_received(move(last));
+            coalescer.segment_received(data_seg(8, "ij"));
+
+            const auto segments = drain(coalescer);
+            if (segments.size() != 2) {
+                throw runtime_error("expected 2 segments, got " + to_string(segments.size()));
+            }
+            const TCPHeader &merged = segments[0].header();
+            if (segments[0].payload().str() != "abcdefgh" or merged.seqno != isn or not merged.fin or
+                not merged.psh or merged.ackno != ackno) {
+                throw runtime_error("consecutive segments not merged");
+            }
+            if (segments[1].payload().str() != "ij" or segments[1].header().seqno != isn + 8) {
+                throw runtime_error("segment after a FIN merged");
+            }
+            if (segments[0].segments_merged() != 3 or segments[0].gso_size() != 3 or
+                segments[1].segments_merged() != 1 or segments[1].gso_size() != 0) {
+                throw runtime_error("merged segments not counted");
+            }
+        }
+
+        // gaps, new acknos, window updates and pure ACKs each start a new run
+        {
+            SegmentCoalescer coalescer;
+            coalescer.segment_received(data_seg(0, "abc"));
+            coalescer.segment_received(data_seg(4, "efg"));
+            TCPSegment new_ackno = data_seg(7, "hij");
+            new_ackno.header().ackno = ackno + 1;
+            coalescer.segment_received(move(new_ackno));
+            TCPSegment new_win = data_seg(10, "klm");
+            new_win.header().ackno = ackno + 1;
+            new_win.header().win = 2000;
+            coalescer.segment_received(move(new_win));
+            coalescer.segment_received(data_seg(0, ""));
+            coalescer.segment_received(data_seg(0, ""));
+
+            const auto segments = drain(coalescer);
+            if (segments.size() != 6) {
+                throw runtime_error("expected 6 segments, got " + to_string(segments.size()));
+            }
+        }
+
+        // a different ECN codepoint or a CWR starts a new run
+        {
+            SegmentCoalescer coalescer;
+            coalescer.segment_received(data_seg(0, "abc"));
+            TCPSegment marked = data_seg(3, "def");
+            marked.ecn() = IPv4Header::ECN_CE;
+            coalescer.segment_received(move(marked));
+            TCPSegment cwr = data_seg(6, "ghi");
+            cwr.ecn() = IPv4Header::ECN_CE;
+            cwr.header().cwr = true;
+            coalescer.segment_received(move(cwr));
+
+            if (drain(coalescer).size() != 3) {
+                throw runtime_error("segments with different ECN state merged");
+            }
+        }
+
+        // no merged segment holds more than the limit
+        {
+            SegmentCoalescer coalescer{5};
+            coalescer.segment_received(data_seg(0, "ab"));
+            coalescer.segment_received(data_seg(2, "cd"));
+            coalescer.segment_received(data_seg(4, "ef"));
+
+            const auto segments = drain(coalescer);
+            if (segments.size() != 2 or segments[0].payload().str() != "abcd" or
+                segments[1].payload().str() != "ef") {
+                throw runtime_error("merged past the limit");
+            }
+        }
+
+        // a lone segment keeps its payload as it was
+        {
+            SegmentCoalescer coalescer;
+            TCPSegment seg = data_seg(0, "abc");
+            const Buffer payload = seg.payload();
+            coalescer.segment_received(move(seg));
+            const auto segments = drain(coalescer);
+            if (segments.size() != 1 or segments[0].payload().str().data() != payload.str().data()) {
+                throw runtime_error("lone segment's payload copied");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
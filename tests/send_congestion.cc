@@ -0,0 +1,177 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without congestion control only the receiver's window applies", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(ExpectCongestionWindow{SIZE_MAX});
+            test.execute(WriteBytes{string(10000, 'a')});
+            for (unsigned int i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Reno starts with four segments and grows one segment per ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4000});
+            test.execute(WriteBytes{string(10000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{4000});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{5000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 4000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 5000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Reno collapses the window on timeout, then avoids congestion", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectCongestionWindow{1000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{2 * size_t{cfg.rt_timeout}});
+            test.execute(ExpectCongestionWindow{1000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+
+            // slow start up to ssthresh (half of the 4000 bytes that were in flight)
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(WriteBytes{string(5000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 4000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 5000));
+            test.execute(ExpectNoSegment{});
+
+            // congestion avoidance: one segment per window of acknowledged data
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 6000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 6000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 7000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 8000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC grows past its threshold and backs off on timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4000});
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectCongestionWindow{1000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+
+            // slow start up to ssthresh (70% of the 4000-byte window)
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(WriteBytes{string(2000, 'b')});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3000});
+
+            // past ssthresh, growth follows the cubic curve, at most half a window per window of data
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 6000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3058});
+            test.execute(Tick{5000});
+            test.execute(WriteBytes{string(3000, 'c')});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 7000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3558});
+        }
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Bbr;
+
+            TCPSenderTestHarness test{"BBR paces segments once it has a bandwidth estimate", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4000});
+
+            // the first round is unpaced and limited to the initial window
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4000}}.with_win(60000));
+            test.execute(WriteBytes{string(4000, 'b')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // 4000 bytes per 10 ms round: pace at 2.885 * 400 bytes per ms
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 8000}}.with_win(60000));
+            test.execute(WriteBytes{string(10000, 'c')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 8000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 9000));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 11000));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "ipv4_header.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"ECN-Echo halves the window once per window of data, then CWR is sent", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn).with_ecn(IPv4Header::ECN_NOT_ECT));
+            test.execute(EnableEcn{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(6000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {  // the initial congestion window
+                test.execute(ExpectSegment{}
+                                 .with_payload_size(1000)
+                                 .with_seqno(isn + 1 + 1000 * i)
+                                 .with_cwr(false)
+                                 .with_ecn(IPv4Header::ECN_ECT0));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // 3000 bytes in flight when the mark is reported
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_ece());
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+
+            // marks on the rest of the same window don't count again
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(10000).with_ece());
+            test.execute(ExpectCongestionWindow{3000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 4001).with_cwr(true));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 5001).with_cwr(false));
+            test.execute(ExpectNoSegment{});
+
+            // but one on the next window does
+            test.execute(AckReceived{WrappingInt32{isn + 5001}}.with_win(10000).with_ece());
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(WriteBytes{string(1000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 6001).with_cwr(true));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"ECN-Echo on a duplicate ACK counts too", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(EnableEcn{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectCongestionWindow{5000});
+
+            // 3000 bytes in flight when the mark is reported
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_ece());
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4001}}.with_win(10000));
+            test.execute(WriteBytes{string(1000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 4001).with_cwr(true));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Retransmissions aren't ECN-capable", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_seqno(isn));
+            test.execute(EnableEcn{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{"hello"});
+            test.execute(ExpectSegment{}.with_data("hello").with_ecn(IPv4Header::ECN_ECT0));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data("hello").with_ecn(IPv4Header::ECN_NOT_ECT));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Without ECN, data isn't ECN-capable and ECN-Echo is ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(2000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_ecn(IPv4Header::ECN_NOT_ECT));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_ecn(IPv4Header::ECN_NOT_ECT));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_ece());
+            test.execute(ExpectCongestionWindow{5000});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
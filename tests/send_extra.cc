@@ -422,6 +422,8 @@ int main() {
             test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000));
+            // three duplicate ACKs with data outstanding: fast retransmit
+            test.execute(ExpectSegment{}.with_payload_size(4).with_data("ijkl").with_seqno(isn + 8).with_fin(true));
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
@@ -0,0 +1,166 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Third duplicate ACK retransmits without waiting for the timer", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'a')});
+            for (unsigned int i = 0; i < 5; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(10000));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(10000));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5000}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Fast retransmit is not a timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // the timer keeps running from the original transmission, and only the timeout doubles it
+            test.execute(Tick{cfg.rt_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1}.with_max_retx_exceeded(false));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(Tick{2 * size_t{cfg.rt_timeout} - 1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Window updates and data segments are not duplicate ACKs", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(11000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(12000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(12000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(12000).carrying_data());
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(12000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(12000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Reno halves the window and inflates it during fast recovery", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{2000 + 3000});
+
+            // each further duplicate lets one new segment out
+            test.execute(WriteBytes{string(2000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 4000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000 + 4000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 5000));
+            test.execute(ExpectNoSegment{});
+
+            // the retransmission is acknowledged: deflate to ssthresh, then count what the ACK covers,
+            // more than a window's worth in congestion avoidance
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 6000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3000});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"NewReno retransmits the next hole on a partial ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // the first and third segments were lost
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2000}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 2000));
+            test.execute(ExpectCongestionWindow{5000 - 2000 + 1000});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000 + 1000});  // (ssthresh, and a window's worth acknowledged)
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include "sender_harness.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.mss = 500;
+
+            TCPSenderTestHarness test{"Segments are no larger than the configured MSS", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(1200, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 501));
+            test.execute(ExpectSegment{}.with_payload_size(200).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.mss = 1460;
+            cfg.mtu_probing = true;
+
+            TCPSenderTestHarness test{"A probe that gets through raises the MSS", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            // halfway between MAX_PAYLOAD_SIZE and the configured MSS
+            test.execute(ExpectSegment{}.with_payload_size(1230).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1231));
+            test.execute(ExpectSegment{}.with_payload_size(770).with_seqno(isn + 2231));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(10000));
+            test.execute(WriteBytes{string(4000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1345).with_seqno(isn + 3001));
+            test.execute(ExpectSegment{}.with_payload_size(1230).with_seqno(isn + 4346));
+            test.execute(ExpectSegment{}.with_payload_size(1230).with_seqno(isn + 5576));
+            test.execute(ExpectSegment{}.with_payload_size(195).with_seqno(isn + 6806));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.mss = 1460;
+            cfg.mtu_probing = true;
+            const size_t rto = cfg.rt_timeout;
+
+            TCPSenderTestHarness test{"A lost probe is resent in MSS-sized pieces, without backoff", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1230).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1231));
+            test.execute(ExpectSegment{}.with_payload_size(770).with_seqno(isn + 2231));
+
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1).with_data(string(1000, 'a')));
+            test.execute(ExpectSegment{}.with_payload_size(230).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{3000});
+
+            // the timer restarts at the same timeout
+            test.execute(Tick{rto - 1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+
+            // the next probe is smaller
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(10000));
+            test.execute(WriteBytes{string(2000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1115).with_seqno(isn + 3001));
+            test.execute(ExpectSegment{}.with_payload_size(885).with_seqno(isn + 4116));
+        }
+
+        {
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().mss = 1460;
+            syn.header().window_scale = 7;
+            syn.header().fit_options();
+
+            TCPSegment parsed;
+            if (parsed.parse(syn.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("segment with an MSS option failed to parse");
+            }
+            if (parsed.header().mss != 1460 or parsed.header().window_scale != 7) {
+                throw runtime_error("MSS option did not survive serialization");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
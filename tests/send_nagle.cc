@@ -0,0 +1,73 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle holds back small writes while data is in flight", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            test.execute(WriteBytes{"b"});
+            test.execute(WriteBytes{"c"});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_data("bc").with_seqno(isn + 2));
+
+            // full segments go out at once, and only the remainder waits
+            test.execute(WriteBytes{string(1500, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1004}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 1004));
+
+            // the end of the stream isn't held back
+            test.execute(WriteBytes{"d"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Close{});
+            test.execute(ExpectSegment{}.with_data("d").with_fin(true).with_seqno(isn + 1504));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Corked writes share a segment", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(Cork{true});
+            test.execute(WriteBytes{"hello"});
+            test.execute(WriteBytes{", "});
+            test.execute(WriteBytes{"world"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Cork{false});
+            test.execute(ExpectSegment{}.with_data("hello, world").with_seqno(isn + 1));
+            test.execute(WriteBytes{"!"});
+            test.execute(ExpectSegment{}.with_data("!").with_seqno(isn + 13));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#include "fd_adapter.hh"
+#include "ipv4_datagram.hh"
+#include "lossy_fd_adapter.hh"
+#include "sender_harness.hh"
+#include "tcp_over_ip.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+//! put `packets` in place of the first of `segments`
+void replace_front(queue<TCPSegment> &segments, queue<TCPSegment> &&packets) {
+    segments.pop();
+    while (not segments.empty()) {
+        packets.push(move(segments.front()));
+        segments.pop();
+    }
+    segments = move(packets);
+}
+
+//! Pass the next segment through a TCPOverIPv4Adapter, and put the packets it sends, as parsed off the wire,
+//! in its place
+struct SendOverIp : public SenderAction {
+    string description() const { return "send the next segment over IPv4"; }
+
+    void execute(TCPSender &, queue<TCPSegment> &segments) const {
+        if (segments.empty()) {
+            throw SegmentExpectationViolation::violated_verb("existed");
+        }
+        TCPOverIPv4Adapter adapter;
+        queue<TCPSegment> packets;
+        for (const auto &dgram : adapter.wrap_tcp_in_ip(segments.front())) {
+            InternetDatagram received;
+            TCPSegment packet;
+            if (received.parse(dgram.serialize().concatenate()) != ParseResult::NoError or
+                packet.parse(received.payload(), received.header().pseudo_cksum()) != ParseResult::NoError) {
+                throw SenderExpectationViolation("a datagram didn't parse, or had a bad checksum");
+            }
+            packet.ecn() = received.header().ecn();
+            packets.push(move(packet));
+        }
+        replace_front(segments, move(packets));
+    }
+};
+
+//! An adapter that just keeps what is written to it
+class PacketCollector : public FdAdapterBase {
+  private:
+    queue<TCPSegment> &_packets;
+
+  public:
+    explicit PacketCollector(queue<TCPSegment> &packets) : _packets(packets) {}
+
+    void write(TCPSegment &seg) { _packets.push(seg); }
+};
+
+//! Pass the next segment through a LossyFdAdapter that drops nothing, and put the packets it writes in its place
+struct SendThroughLossyAdapter : public SenderAction {
+    string description() const { return "send the next segment through a LossyFdAdapter"; }
+
+    void execute(TCPSender &, queue<TCPSegment> &segments) const {
+        if (segments.empty()) {
+            throw SegmentExpectationViolation::violated_verb("existed");
+        }
+        queue<TCPSegment> packets;
+        LossyFdAdapter<PacketCollector> adapter{PacketCollector{packets}};
+        adapter.write(segments.front());
+        replace_front(segments, move(packets));
+    }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        string data(3500, 0);
+        for (auto &ch : data) {
+            ch = static_cast<char>(rd());
+        }
+
+        TCPConfig cfg;
+        cfg.segmentation_offload = true;
+
+        // the segment the sender makes of `data` and a FIN, for the adapter to split into packets
+        const auto send_data = [&](TCPSenderTestHarness &test, const WrappingInt32 isn) {
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(data)}.with_end_input(true));
+        };
+
+        // the packets it should be split into: mss of payload each, and FIN only on the last
+        const auto expect_packets = [&](TCPSenderTestHarness &test, const WrappingInt32 isn) {
+            for (size_t offset = 0; offset < data.size(); offset += cfg.mss) {
+                const string payload = data.substr(offset, cfg.mss);
+                test.execute(ExpectSegment{}
+                                 .with_seqno(isn + 1 + offset)
+                                 .with_data(payload)
+                                 .with_fin(offset + payload.size() == data.size())
+                                 .with_gso_size(0));
+            }
+            test.execute(ExpectNoSegment{});
+        };
+
+        {
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"One segment carries all the data, to be split by mss", cfg};
+            send_data(test, isn);
+            test.execute(
+                ExpectSegment{}.with_seqno(isn + 1).with_data(data).with_fin(true).with_gso_size(cfg.mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{data.size() + 1});
+        }
+
+        {
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"The IPv4 adapter splits it into packets", cfg};
+            send_data(test, isn);
+            test.execute(SendOverIp{});
+            expect_packets(test, isn);
+        }
+
+        {
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"So does the lossy adapter, before it decides what to drop", cfg};
+            send_data(test, isn);
+            test.execute(SendThroughLossyAdapter{});
+            expect_packets(test, isn);
+        }
+
+        {
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"A lost packet is sent again on its own, and each packet's ACK counts", cfg};
+            send_data(test, isn);
+            test.execute(ExpectSegment{}.with_payload_size(data.size()).with_gso_size(cfg.mss));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(
+                ExpectSegment{}.with_seqno(isn + 1).with_payload_size(cfg.mss).with_fin(false).with_gso_size(0));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * cfg.mss}}.with_win(10000));
+            test.execute(ExpectBytesInFlight{data.size() + 1 - 2 * cfg.mss});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
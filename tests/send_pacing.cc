@@ -0,0 +1,79 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.pacing_rate = 100000;  // a segment every 10 ms
+
+            TCPSenderTestHarness test{"Pacing at a configured rate", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'a')});
+
+            // a burst as big as the token bucket, then one segment at a time
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(Tick{9});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // an idle sender can burst again, but no more than the bucket holds
+            test.execute(AckReceived{WrappingInt32{isn + 5001}}.with_win(10000));
+            test.execute(Tick{1000});
+            test.execute(WriteBytes{string(3000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 5001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 6001));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Pacing at a rate from the window and the RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{50});
+            // 1.2 * 6000 bytes per 50 ms is 144 bytes per millisecond: a segment every 7 ms or so
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(6000));
+            test.execute(WriteBytes{string(6000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+            for (unsigned int i = 0; i < 2; i++) {
+                test.execute(Tick{6});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001 + 1000 * i));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
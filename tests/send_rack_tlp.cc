@@ -0,0 +1,334 @@
+#include "fd_adapter.hh"
+#include "lossy_fd_adapter.hh"
+#include "sender_harness.hh"
+#include "tcp_connection.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+//! A one-way link with a fixed delay, in simulated time
+class DelayedLink : public FdAdapterBase {
+  private:
+    size_t _delay_ms;
+    size_t _now{0};
+    queue<pair<size_t, TCPSegment>> _in_transit{};
+
+  public:
+    explicit DelayedLink(const size_t delay_ms) : _delay_ms(delay_ms) {}
+
+    optional<TCPSegment> read() {
+        if (_in_transit.empty() or _in_transit.front().first > _now) {
+            return {};
+        }
+        auto seg = move(_in_transit.front().second);
+        _in_transit.pop();
+        return seg;
+    }
+
+    void write(TCPSegment &seg) { _in_transit.emplace(_now + _delay_ms, seg); }
+
+    void tick(const size_t ms_since_last_tick) { _now += ms_since_last_tick; }
+};
+
+//! \returns how long after the server starts to respond the client has the whole response, when the last
+//! `tail_drops` segments of the response are lost on the way
+size_t request_response(const TCPConfig &cfg,
+                        const size_t delay_ms,
+                        const size_t response_len,
+                        const size_t tail_drops) {
+    constexpr size_t max_ms = 10 * 1000;
+
+    TCPConnection client{cfg}, server{cfg};
+    LossyFdAdapter<DelayedLink> uplink{DelayedLink{delay_ms}}, downlink{DelayedLink{delay_ms}};
+
+    const size_t response_segments = (response_len + cfg.mss - 1) / cfg.mss;
+    size_t response_sent = 0;
+    optional<size_t> response_start{};
+
+    client.connect();
+    client.write("GET /");
+    client.end_input_stream();
+
+    for (size_t ms = 0; ms < max_ms; ms++) {
+        while (not client.segments_out().empty()) {
+            uplink.write(client.segments_out().front());
+            client.segments_out().pop();
+        }
+        for (auto seg = uplink.read(); seg.has_value(); seg = uplink.read()) {
+            server.segment_received(seg.value());
+        }
+
+        server.inbound_stream().read(server.inbound_stream().buffer_size());
+        if (server.inbound_stream().eof() and not response_start.has_value()) {
+            server.cork();  // so that the FIN goes out with the last, partial segment
+            server.write(string(response_len, 'x'));
+            server.end_input_stream();
+            server.uncork();
+            response_start = ms;
+        }
+
+        while (not server.segments_out().empty()) {
+            TCPSegment &seg = server.segments_out().front();
+            if (seg.payload().size() > 0 and response_sent < response_segments) {  // first transmission
+                response_sent++;
+                downlink.config_mut().loss_rate_up = response_sent + tail_drops > response_segments ? UINT16_MAX : 0;
+            } else {
+                downlink.config_mut().loss_rate_up = 0;
+            }
+            downlink.write(seg);
+            server.segments_out().pop();
+        }
+        for (auto seg = downlink.read(); seg.has_value(); seg = downlink.read()) {
+            client.segment_received(seg.value());
+        }
+
+        if (client.inbound_stream().input_ended()) {
+            if (client.inbound_stream().buffer_size() != response_len) {
+                throw runtime_error("response incomplete");
+            }
+            return ms - response_start.value();
+        }
+
+        client.tick(1);
+        server.tick(1);
+        uplink.tick(1);
+        downlink.tick(1);
+    }
+
+    throw runtime_error("response never arrived");
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = true;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"A loss probe finds a lost tail two RTTs after the last ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(Tick{19});
+            test.execute(ExpectNoSegment{});
+
+            // with no new data to send, the probe is the last segment again
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(ExpectNoSegment{});
+
+            // its SACK shows that the segment before it is lost too
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_sack(isn + 2001, isn + 3001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(10000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(Tick{1000});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"A loss probe sends new data when there is some", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(6000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {  // the initial congestion window
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{19});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 4001));
+            test.execute(ExpectNoSegment{});
+
+            // only one probe until it is acknowledged; after that, the retransmission timer
+            test.execute(Tick{100});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{900});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = true;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"RACK allows a quarter of the minimum RTT for reordering", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(2000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = true;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"A reordered segment isn't retransmitted", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(2000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 1001, isn + 2001));
+            test.execute(Tick{1});
+            test.execute(AckReceived{WrappingInt32{isn + 2001}}.with_win(10000));
+            test.execute(Tick{10});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = true;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"RACK goes by when a segment was last sent, not by its seqno", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(Tick{5});
+            test.execute(WriteBytes{string(1000, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 3001));
+            test.execute(Tick{5});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 2001, isn + 3001));
+            test.execute(Tick{2});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+
+            // the last segment was sent after the first two, but before they were sent again
+            test.execute(Tick{3});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 2001, isn + 4001));
+            test.execute(Tick{20});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4001}}.with_win(10000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = true;
+            cfg.rack_tlp = true;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Segments RACK finds lost go out again only as the window allows", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(30000));
+            test.execute(WriteBytes{string(30000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(Tick{10});
+            for (unsigned int i = 1; i <= 4; i++) {  // slow start, to a window of 10 segments
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 1000 * i}}.with_win(30000));
+            }
+            test.execute(Tick{10});
+            for (unsigned int i = 5; i <= 6; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 1000 * i}}.with_win(30000));
+            }
+            for (unsigned int i = 4; i < 16; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectCongestionWindow{10000});
+
+            // the last segment is SACKed: the six sent 10 ms before it are lost, and the window is cut to 8 segments
+            // with the three sent along with it still in the network, so five of the six go out again
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 6001}}.with_win(30000).with_sack(isn + 15001, isn + 16001));
+            test.execute(ExpectCongestionWindow{8000});
+            for (unsigned int i = 6; i < 11; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // the three sent with the SACKed one are lost too
+            test.execute(Tick{2});
+            for (unsigned int i = 11; i < 14; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // another duplicate acknowledgment makes room for the last of them
+            test.execute(AckReceived{WrappingInt32{isn + 6001}}.with_win(30000).with_sack(isn + 15001, isn + 16001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 14001));
+            test.execute(ExpectNoSegment{});
+        }
+
+        // a request, and a response whose last two segments are lost
+        {
+            constexpr size_t delay_ms = 10;
+            TCPConfig cfg;
+            cfg.sack = true;
+            const size_t without = request_response(cfg, delay_ms, 4500, 2);
+            if (without < cfg.rt_timeout) {
+                throw runtime_error("lost tail repaired before the retransmission timeout without RACK-TLP");
+            }
+
+            cfg.rack_tlp = true;
+            const size_t with = request_response(cfg, delay_ms, 4500, 2);
+            if (with > 5 * 2 * delay_ms) {  // a round trip for the response, two for the probe timeout, and two more
+                throw runtime_error("lost tail took " + to_string(with) + " ms to repair with RACK-TLP");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "buffer.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <string>
+
+using namespace std;
+
+//! Keep a reference to the payload of the next segment, without taking the segment
+struct KeepPayload : public SenderAction {
+    Buffer &_kept;
+
+    explicit KeepPayload(Buffer &kept) : _kept(kept) {}
+    string description() const { return "keep the next segment's payload"; }
+
+    void execute(TCPSender &, queue<TCPSegment> &segments) const {
+        if (segments.empty()) {
+            throw SegmentExpectationViolation::violated_verb("existed");
+        }
+        _kept = segments.front().payload();
+    }
+};
+
+//! The next segment's payload is the very bytes of a kept one, not a copy of them
+struct ExpectSharedPayload : public SenderExpectation {
+    const Buffer &_kept;
+
+    explicit ExpectSharedPayload(const Buffer &kept) : _kept(kept) {}
+    string description() const { return "payload shared with the kept one"; }
+
+    void execute(TCPSender &, queue<TCPSegment> &segments) const {
+        if (segments.empty()) {
+            throw SegmentExpectationViolation::violated_verb("existed");
+        }
+        const string_view payload = segments.front().payload().str();
+        if (payload != _kept.str()) {
+            throw SegmentExpectationViolation("The Sender produced a segment whose payload differs from the kept one");
+        }
+        if (payload.data() != _kept.str().data()) {
+            throw SegmentExpectationViolation("The Sender produced a segment with a copy of the kept payload");
+        }
+    }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            Buffer original;
+            TCPSenderTestHarness test{"A retransmission shares its payload with the original", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"hello"});
+            test.execute(KeepPayload{original});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("hello"));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSharedPayload{original});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("hello"));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            Buffer original;
+            TCPSenderTestHarness test{"So does each one after it, as the timer backs off", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"}.with_end_input(true));
+            test.execute(KeepPayload{original});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc").with_fin(true));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSharedPayload{original});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc").with_fin(true));
+            test.execute(Tick{2u * cfg.rt_timeout});
+            test.execute(ExpectSharedPayload{original});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc").with_fin(true));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
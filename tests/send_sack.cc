@@ -0,0 +1,172 @@
+#include "sender_harness.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SACK repairs every hole in one recovery", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(6000, 'a')});
+            for (unsigned int i = 0; i < 6; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+
+            // the first and third segments are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 1001, isn + 2001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 4001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 5001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 6001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(ExpectNoSegment{});
+
+            // everything else was SACKed, so there is nothing more to send again
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 6001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 6001}}.with_win(10000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SACK blocks outside of the flight are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(4000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_sack(isn, isn + 1001));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_sack(isn + 3001, isn + 9001));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000).with_sack(isn + 3001, isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+
+            // with an empty scoreboard, further duplicates only say that something arrived
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"A segment only partly SACKed is still a hole", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(6000, 'a')});
+            for (unsigned int i = 0; i < 6; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 1001, isn + 3501));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 4001, isn + 5001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 4001, isn + 6001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // past the SACKed range, to the segment it ends in
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 3001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 6001}}.with_win(10000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            WrappingInt32 isn(rd());
+            TCPReceiver receiver{4000};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            receiver.segment_received(syn);
+
+            const auto arrive = [&](const uint32_t offset, const size_t length) {
+                TCPSegment seg;
+                seg.header().seqno = isn + 1 + offset;
+                seg.payload() = string(length, 'x');
+                receiver.segment_received(seg);
+            };
+            arrive(100, 100);
+            arrive(400, 100);
+            arrive(300, 100);
+            arrive(600, 10);
+
+            // the block holding the latest arrival comes first, then the rest in order
+            const auto blocks = receiver.sack_blocks(3);
+            const vector<pair<WrappingInt32, WrappingInt32>> expected{
+                {isn + 601, isn + 611}, {isn + 101, isn + 201}, {isn + 301, isn + 501}};
+            if (blocks != expected) {
+                throw runtime_error("unexpected SACK blocks from the receiver");
+            }
+            if (receiver.sack_blocks(1).size() != 1) {
+                throw runtime_error("receiver returned more SACK blocks than asked for");
+            }
+
+            // the blocks survive a trip through the wire format
+            TCPSegment ack;
+            ack.header().ack = true;
+            ack.header().ackno = receiver.ackno().value();
+            ack.header().sack_permitted = true;
+            ack.header().sack_blocks = blocks;
+            ack.header().fit_options();
+            if (ack.header().doff != 5 + (4 + 4 + 8 * 3) / 4) {
+                throw runtime_error("unexpected data offset with SACK options");
+            }
+
+            TCPSegment parsed;
+            if (parsed.parse(ack.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("segment with SACK options failed to parse");
+            }
+            if (not parsed.header().sack_permitted or parsed.header().sack_blocks != expected) {
+                throw runtime_error("SACK options did not survive serialization");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
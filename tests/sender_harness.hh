@@ -99,6 +99,22 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    size_t _n_bytes;
+
+    ExpectCongestionWindow(size_t n_bytes) : _n_bytes(n_bytes) {}
+    std::string description() const { return "congestion window of " + std::to_string(_n_bytes) + " bytes"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_window() != _n_bytes) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << sender.congestion_window()
+               << " bytes, but it was expected to be " << _n_bytes << " bytes";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +207,23 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    bool _pure_ack{true};
+    bool _ece{false};
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> _sack_blocks{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        if (not _pure_ack) {
+            ss << " on a data segment";
+        }
+        if (_ece) {
+            ss << " with ECE";
+        }
+        for (const auto &[left, right] : _sack_blocks) {
+            ss << " sack " << left.raw_value() << "-" << right.raw_value();
+        }
         return ss.str();
     }
 
@@ -204,12 +232,51 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &carrying_data() {
+        _pure_ack = false;
+        return *this;
+    }
+
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack_blocks.emplace_back(left, right);
+        return *this;
+    }
+
+    AckReceived &with_ece() {
+        _ece = true;
+        return *this;
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (not _sack_blocks.empty()) {
+            sender.sack_received(_sack_blocks);
+        }
+        if (_ece) {
+            sender.ecn_echo_received();
+        }
+        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), _pure_ack);
+        sender.fill_window();
+    }
+};
+
+struct Cork : public SenderAction {
+    bool _corked;
+
+    Cork(const bool corked) : _corked(corked) {}
+    std::string description() const { return _corked ? "cork" : "uncork"; }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        sender.set_corked(_corked);
         sender.fill_window();
     }
 };
 
+struct EnableEcn : public SenderAction {
+    std::string description() const { return "enable ECN"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.set_ecn(true); }
+};
+
 struct Close : public SenderAction {
     Close() {}
     std::string description() const { return "close"; }
@@ -225,11 +292,14 @@ struct ExpectSegment : public SenderExpectation {
     std::optional<bool> rst{};
     std::optional<bool> syn{};
     std::optional<bool> fin{};
+    std::optional<bool> cwr{};
     std::optional<WrappingInt32> seqno{};
     std::optional<WrappingInt32> ackno{};
     std::optional<uint16_t> win{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
+    std::optional<uint8_t> ecn{};
+    std::optional<size_t> gso_size{};
 
     ExpectSegment &with_ack(bool ack_) {
         ack = ack_;
@@ -251,6 +321,11 @@ struct ExpectSegment : public SenderExpectation {
         return *this;
     }
 
+    ExpectSegment &with_cwr(bool cwr_) {
+        cwr = cwr_;
+        return *this;
+    }
+
     ExpectSegment &with_no_flags() {
         ack = false;
         rst = false;
@@ -288,6 +363,18 @@ struct ExpectSegment : public SenderExpectation {
         return *this;
     }
 
+    //! the ECN codepoint for the IP datagram the segment goes out in
+    ExpectSegment &with_ecn(uint8_t ecn_) {
+        ecn = ecn_;
+        return *this;
+    }
+
+    //! the most payload bytes per packet, with segmentation offload (0: the segment is one packet)
+    ExpectSegment &with_gso_size(size_t gso_size_) {
+        gso_size = gso_size_;
+        return *this;
+    }
+
     std::string segment_description() const {
         std::ostringstream o;
         o << "(";
@@ -303,6 +390,9 @@ struct ExpectSegment : public SenderExpectation {
         if (fin.has_value()) {
             o << (fin.value() ? "F=1," : "F=0,");
         }
+        if (cwr.has_value()) {
+            o << (cwr.value() ? "C=1," : "C=0,");
+        }
         if (ackno.has_value()) {
             o << "ackno=" << ackno.value() << ",";
         }
@@ -315,6 +405,12 @@ struct ExpectSegment : public SenderExpectation {
         if (payload_size.has_value()) {
             o << "payload_size=" << payload_size.value() << ",";
         }
+        if (ecn.has_value()) {
+            o << "ecn=" << unsigned(ecn.value()) << ",";
+        }
+        if (gso_size.has_value()) {
+            o << "gso_size=" << gso_size.value() << ",";
+        }
         if (data.has_value()) {
             o << "\"";
             for (unsigned int i = 0; i < std::min(size_t(16), data.value().size()); i++) {
@@ -336,7 +432,7 @@ struct ExpectSegment : public SenderExpectation {
 
     virtual std::string description() const { return "segment sent with " + segment_description(); }
 
-    void execute(TCPSender &, std::queue<TCPSegment> &segments) const {
+    void execute(TCPSender &sender, std::queue<TCPSegment> &segments) const {
         if (segments.empty()) {
             throw SegmentExpectationViolation::violated_verb("existed");
         }
@@ -354,6 +450,9 @@ struct ExpectSegment : public SenderExpectation {
         if (fin.has_value() and seg.header().fin != fin.value()) {
             throw SegmentExpectationViolation::violated_field("fin", fin.value(), seg.header().fin);
         }
+        if (cwr.has_value() and seg.header().cwr != cwr.value()) {
+            throw SegmentExpectationViolation::violated_field("cwr", cwr.value(), seg.header().cwr);
+        }
         if (seqno.has_value() and seg.header().seqno != seqno.value()) {
             throw SegmentExpectationViolation::violated_field("seqno", seqno.value(), seg.header().seqno);
         }
@@ -367,8 +466,16 @@ struct ExpectSegment : public SenderExpectation {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
         }
-        if (seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
-            throw SegmentExpectationViolation("packet has length (" + std::to_string(seg.payload().size()) +
+        if (ecn.has_value() and seg.ecn() != ecn.value()) {
+            throw SegmentExpectationViolation::violated_field("ecn", unsigned(ecn.value()), unsigned(seg.ecn()));
+        }
+        if (gso_size.has_value() and seg.gso_size() != gso_size.value()) {
+            throw SegmentExpectationViolation::violated_field("gso_size", gso_size.value(), seg.gso_size());
+        }
+        // (with segmentation offload, it is each packet that must fit)
+        const size_t packet_size = seg.gso_size() > 0 ? seg.gso_size() : seg.payload().size();
+        if (packet_size > sender.max_probe_size() or seg.payload().size() > TCPConfig::MAX_OFFLOAD_SIZE) {
+            throw SegmentExpectationViolation("packet has length (" + std::to_string(packet_size) +
                                               ") greater than the maximum");
         }
         if (data.has_value() and seg.payload().str() != data.value()) {
@@ -394,7 +501,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -387,11 +387,20 @@ struct SendSegment : public TCPAction {
     bool rst{false};
     bool syn{false};
     bool fin{false};
+    bool cwr{false};
+    bool ece{false};
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{0};
     size_t payload_size{0};
+    uint8_t ecn{0};
     std::string data{};
+    std::optional<uint16_t> mss{};
+    std::optional<uint8_t> window_scale{};
+    bool sack_permitted{false};
+    std::optional<std::pair<uint32_t, uint32_t>> timestamps{};
+    size_t segments_merged{1};
+    size_t gso_size{0};
 
     SendSegment() {}
 
@@ -400,10 +409,13 @@ struct SendSegment : public TCPAction {
         rst = seg.header().rst;
         syn = seg.header().syn;
         fin = seg.header().fin;
+        cwr = seg.header().cwr;
+        ece = seg.header().ece;
         seqno = seg.header().seqno;
         ackno = seg.header().ackno;
         win = seg.header().win;
         data = seg.payload();
+        ecn = seg.ecn();
     }
 
     SendSegment &with_ack(bool ack_) {
@@ -426,6 +438,22 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_cwr(bool cwr_) {
+        cwr = cwr_;
+        return *this;
+    }
+
+    SendSegment &with_ece(bool ece_) {
+        ece = ece_;
+        return *this;
+    }
+
+    //! the ECN codepoint of the IP datagram the segment arrives in
+    SendSegment &with_ecn(uint8_t ecn_) {
+        ecn = ecn_;
+        return *this;
+    }
+
     SendSegment &with_seqno(WrappingInt32 seqno_) {
         seqno = seqno_;
         return *this;
@@ -445,6 +473,33 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_mss(uint16_t mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    SendSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t value, uint32_t echo_reply) {
+        timestamps.emplace(value, echo_reply);
+        return *this;
+    }
+
+    //! the segment is `segments_merged_` segments of at most `gso_size_` bytes, merged by receive offload
+    SendSegment &with_merged(size_t segments_merged_, size_t gso_size_) {
+        segments_merged = segments_merged_;
+        gso_size = gso_size_;
+        return *this;
+    }
+
     SendSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -463,9 +518,19 @@ struct SendSegment : public TCPAction {
         data_hdr.rst = rst;
         data_hdr.syn = syn;
         data_hdr.fin = fin;
+        data_hdr.cwr = cwr;
+        data_hdr.ece = ece;
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.mss = mss;
+        data_hdr.window_scale = window_scale;
+        data_hdr.sack_permitted = sack_permitted;
+        data_hdr.timestamps = timestamps;
+        data_hdr.fit_options();
+        data_seg.ecn() = ecn;
+        data_seg.segments_merged() = segments_merged;
+        data_seg.gso_size() = gso_size;
         return data_seg;
     }
 
@@ -59,9 +59,10 @@ int main(int argc, char **argv) {
                 test_1.ackno.raw_value() != tval) {
                 throw runtime_error("bad parse: wrong ackno");
             }
-            if (const uint8_t tval = (test_1.urg ? 0x20 : 0) | (test_1.ack ? 0x10 : 0) | (test_1.psh ? 0x08 : 0) |
-                                     (test_1.rst ? 0x04 : 0) | (test_1.syn ? 0x02 : 0) | (test_1.fin ? 0x01 : 0);
-                tval != (test_header[13] & 0x3f)) {
+            if (const uint8_t tval = (test_1.cwr ? 0x80 : 0) | (test_1.ece ? 0x40 : 0) | (test_1.urg ? 0x20 : 0) |
+                                     (test_1.ack ? 0x10 : 0) | (test_1.psh ? 0x08 : 0) | (test_1.rst ? 0x04 : 0) |
+                                     (test_1.syn ? 0x02 : 0) | (test_1.fin ? 0x01 : 0);
+                tval != test_header[13]) {
                 throw runtime_error("bad parse: bad flags");
             }
             if (const uint16_t tval = (test_header[14] << 8) | test_header[15]; test_1.win != tval) {
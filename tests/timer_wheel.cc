@@ -0,0 +1,107 @@
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TimerWheel wheel;
+            wheel.schedule(1, 10);
+            wheel.schedule(2, 5);
+            wheel.schedule(3, 100000);
+            wheel.schedule(1, 20);  // rescheduled: only the later deadline counts
+            wheel.schedule(4, 7);
+            wheel.cancel(4);
+
+            if (wheel.advance(9) != vector<TimerWheel::TimerId>{2}) {
+                throw runtime_error("advance(9) fired the wrong timers");
+            }
+            if (not wheel.advance(19).empty() or wheel.deadline(1) != 20 or wheel.pending(4)) {
+                throw runtime_error("rescheduled or cancelled timer misbehaved");
+            }
+            if (wheel.advance(99999) != vector<TimerWheel::TimerId>{1}) {
+                throw runtime_error("advance(99999) fired the wrong timers");
+            }
+            if (wheel.advance(100000) != vector<TimerWheel::TimerId>{3} or wheel.size() != 0) {
+                throw runtime_error("advance(100000) fired the wrong timers");
+            }
+
+            // a deadline that has already passed fires on the next advance, even one that doesn't move the clock
+            wheel.schedule(5, 50);
+            if (wheel.advance(100000) != vector<TimerWheel::TimerId>{5}) {
+                throw runtime_error("overdue timer did not fire");
+            }
+        }
+
+        // against a reference: random timers, some far enough out to start in the overflow list
+        for (unsigned int round = 0; round < 20; round++) {
+            TimerWheel wheel;
+            map<TimerWheel::TimerId, size_t> reference;
+            size_t now = 0;
+            for (unsigned int step = 0; step < 5000; step++) {
+                const TimerWheel::TimerId id = rd() % 64;
+                switch (rd() % 4) {
+                    case 0: {
+                        const size_t range = rd() % 8 == 0 ? (size_t{1} << 26) : 3000;
+                        const size_t deadline = now + uniform_int_distribution<size_t>{0, range}(rd);
+                        wheel.schedule(id, deadline);
+                        reference[id] = deadline;
+                        break;
+                    }
+                    case 1:
+                        wheel.cancel(id);
+                        reference.erase(id);
+                        break;
+                    default: {
+                        now += rd() % 16 == 0 ? (size_t{1} << 24) : rd() % 200;
+                        map<TimerWheel::TimerId, size_t> due;
+                        for (auto it = reference.begin(); it != reference.end();) {
+                            if (it->second <= now) {
+                                due.insert(*it);
+                                it = reference.erase(it);
+                            } else {
+                                ++it;
+                            }
+                        }
+                        const auto fired = wheel.advance(now);
+                        if (fired.size() != due.size()) {
+                            throw runtime_error("at " + to_string(now) + ", " + to_string(fired.size()) +
+                                                " timers fired instead of " + to_string(due.size()));
+                        }
+                        size_t last_deadline = 0;
+                        for (const auto timer : fired) {
+                            if (due.count(timer) == 0 or wheel.pending(timer)) {
+                                throw runtime_error("timer " + to_string(timer) + " fired when not due");
+                            }
+                            if (due.at(timer) < last_deadline) {
+                                throw runtime_error("timer " + to_string(timer) + " fired out of order");
+                            }
+                            last_deadline = due.at(timer);
+                        }
+                    }
+                }
+                if (wheel.size() != reference.size()) {
+                    throw runtime_error("wheel and reference disagree on the number of pending timers");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}